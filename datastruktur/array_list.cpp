@@ -1,104 +1,241 @@
 #include <iostream>
+#include <iomanip>
+#include <chrono>
 #include <cmath>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
 #include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 using namespace std;
 
+template <class T, class Alloc = allocator<T> >
 class ArrayList
 {
 private:
-  int *data;
+  typedef allocator_traits<Alloc> traits;
+
+  Alloc alloc;
+  T *data;
   int capacity;
   int growth;
   int size;
 
-  // Resizes ArrayList according to growth factor
-  void resize()
+  // Moving the elements to new storage with room for new_capacity
+  // elements. Trivially copyable elements are copied as raw bytes, others
+  // are moved (or copied if moving may throw) and the old ones destroyed.
+  void relocate(int new_capacity)
   {
-    capacity *= growth;
-    int *new_data = new int[capacity];
-    for (int i=0; i<size; i++) {
-      new_data[i] = data[i];
+    T *new_data = traits::allocate(alloc, new_capacity);
+    relocate_to(new_data, is_trivially_copyable<T>());
+    if (data != nullptr) {
+      traits::deallocate(alloc, data, capacity);
     }
-    delete[] data;
     data = new_data;
+    capacity = new_capacity;
   }
 
-  // Shrinking storage array to smallest capacity growth^n
-  void shrink_to_fit()
+  void relocate_to(T *new_data, true_type)
   {
-    capacity = growth;
-    while (capacity <= size) {
-      capacity *= growth;
+    if (size > 0) {
+      memcpy((void*) new_data, (const void*) data, size*sizeof(T));
     }
-    cout << capacity << endl;
+  }
 
-    int *new_data = new int[capacity];
+  void relocate_to(T *new_data, false_type)
+  {
     for (int i=0; i<size; i++) {
-      new_data[i] = data[i];
+      traits::construct(alloc, new_data + i, move_if_noexcept(data[i]));
+      traits::destroy(alloc, data + i);
     }
-    delete[] data;
-    data = new_data;
+  }
+
+  // Resizes ArrayList according to growth factor
+  void resize()
+  {
+    relocate(capacity > 0 ? capacity*growth : 1);
+  }
+
+  // Shrinking storage array to smallest capacity growth^n above size
+  void shrink_to_fit()
+  {
+    int new_capacity = growth;
+    while (new_capacity <= size) {
+      new_capacity *= growth;
+    }
+    relocate(new_capacity);
+  }
+
+  // Destroying all elements and releasing the storage
+  void release()
+  {
+    clear();
+    if (data != nullptr) {
+      traits::deallocate(alloc, data, capacity);
+    }
+    data = nullptr;
+    capacity = 0;
   }
 
 public:
-  // Constructor, creates an empty ArrayList
+  // Constructor, creates an empty ArrayList; no memory until first append
   ArrayList()
   {
+    data = nullptr;
     size = 0;
-    capacity = 1;
+    capacity = 0;
     growth = 2;
-    data = new int[capacity];
   }
 
   // Overloading basic constructor with initial values
-  ArrayList(vector<int> initial)
+  ArrayList(initializer_list<T> initial) : ArrayList()
   {
-    size = 0;
-    capacity = size;
-    growth = 2;
-    data = new int[capacity];
+    reserve(initial.size());
+    for (const T& e: initial) {
+      append(e);
+    }
+  }
 
-    for (int e: initial) {
+  ArrayList(const vector<T>& initial) : ArrayList()
+  {
+    reserve(initial.size());
+    for (const T& e: initial) {
       append(e);
     }
   }
 
+  // Copy constructor: a new array with copies of the elements
+  ArrayList(const ArrayList& other)
+    : alloc(traits::select_on_container_copy_construction(other.alloc))
+  {
+    data = nullptr;
+    size = 0;
+    capacity = 0;
+    growth = other.growth;
+    reserve(other.size);
+    for (int i=0; i<other.size; i++) {
+      append(other.data[i]);
+    }
+  }
+
+  // Move constructor: takes over the storage of other, leaving it empty
+  ArrayList(ArrayList&& other) noexcept : alloc(move(other.alloc))
+  {
+    data = other.data;
+    size = other.size;
+    capacity = other.capacity;
+    growth = other.growth;
+    other.data = nullptr;
+    other.size = 0;
+    other.capacity = 0;
+  }
+
+  ArrayList& operator=(const ArrayList& other)
+  {
+    if (this != &other) {
+      ArrayList copy(other);
+      *this = move(copy);
+    }
+    return *this;
+  }
+
+  ArrayList& operator=(ArrayList&& other) noexcept
+  {
+    if (this != &other) {
+      release();
+      alloc = move(other.alloc);
+      data = other.data;
+      size = other.size;
+      capacity = other.capacity;
+      growth = other.growth;
+      other.data = nullptr;
+      other.size = 0;
+      other.capacity = 0;
+    }
+    return *this;
+  }
+
   // Destructor to free memory
   ~ArrayList()
   {
-    delete[] data;
+    release();
   }
 
   // Getting size of ArrayList
-  int length()
+  int length() const
   {
     return size;
   }
 
+  // Making room for at least n elements without further reallocation
+  void reserve(int n)
+  {
+    if (n > capacity) {
+      relocate(n);
+    }
+  }
+
+  // Removing all elements, keeping the storage
+  void clear()
+  {
+    for (int i=0; i<size; i++) {
+      traits::destroy(alloc, data + i);
+    }
+    size = 0;
+  }
+
   // Printing contents of ArrayList
-  void print()
+  void print() const
   {
     cout << "[";
     for (int i=0; i<size-1; i++) {
       cout << data[i] << ", ";
     }
-    cout << data[size-1] << "]" << endl;
+    if (size > 0) {
+      cout << data[size-1];
+    }
+    cout << "]" << endl;
+  }
+
+  // Appending a value to end of ArrayList, in amortized O(1) time
+  void append(const T& val)
+  {
+    if (size >= capacity) {
+      T copy(val);      // val may be an element of this list
+      resize();
+      traits::construct(alloc, data + size, move(copy));
+    } else {
+      traits::construct(alloc, data + size, val);
+    }
+    size += 1;
   }
 
-  // Appending an integer n to end of ArrayList
-  void append(int n)
+  void append(T&& val)
   {
     if (size >= capacity) {
+      T temp(move(val));
       resize();
+      traits::construct(alloc, data + size, move(temp));
+    } else {
+      traits::construct(alloc, data + size, move(val));
     }
-    data[size] = n;
     size += 1;
   }
 
   // Overloading the []-operators
-  int& operator[](int i) {
+  T& operator[](int i) {
+    if (0 <= i and i < size) {
+      return data[i];
+    } else {
+      throw out_of_range("IndexError");
+    }
+  }
+
+  const T& operator[](int i) const {
     if (0 <= i and i < size) {
       return data[i];
     } else {
@@ -106,15 +243,16 @@ public:
     }
   }
 
-  // Inserting integer val into ArrayList at given index
-  void insert(int val, int index)
+  // Inserting val into ArrayList at given index
+  void insert(const T& val, int index)
   {
     if (0 <= index and index < size) {
-      append(data[size]);
-      for (int i=size-1; i>index; i--) {
-        data[i] = data[i-1];
+      T copy(val);
+      append(move(data[size-1]));
+      for (int i=size-2; i>index; i--) {
+        data[i] = move(data[i-1]);
       }
-      data[index] = val;
+      data[index] = move(copy);
     } else {
       throw out_of_range("IndexError");
     }
@@ -124,9 +262,10 @@ public:
   void remove(int index)
   {
     if (0 <= index and index < size) {
-      for (int i=index; i<size; i++) {
-        data[i] = data[i+1];
+      for (int i=index; i<size-1; i++) {
+        data[i] = move(data[i+1]);
       }
+      traits::destroy(alloc, data + size - 1);
       size -= 1;
     } else {
       throw out_of_range("IndexError");
@@ -138,29 +277,17 @@ public:
   }
 
   // Remove value at given index and return it
-  int pop(int index)
+  T pop(int index)
   {
-    int temp = data[index];
+    T temp = move((*this)[index]);
     remove(index);
-
-    if (size < 0.25*capacity) {
-      shrink_to_fit();
-    }
-
     return temp;
   }
 
   // Overloading pop method with no given index: removes last element
-  int pop()
+  T pop()
   {
-    int temp = data[size-1];
-    remove(size-1);
-
-    if (size < 0.25*capacity) {
-      shrink_to_fit();
-    }
-
-    return temp;
+    return pop(size-1);
   }
 };
 
@@ -174,13 +301,62 @@ bool is_prime(int x)
   return true;
 }
 
-int main()
+// Seconds since an arbitrary fixed point
+double now()
+{
+  using namespace chrono;
+  return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Appends per second of n values to an ArrayList and to a std::vector,
+// starting from empty, best of a few repetitions
+template <class T, class Make>
+void bench_append(string name, int n, Make make)
 {
+  double best_list = 1e30, best_vector = 1e30;
+  for (int rep=0; rep<5; rep++) {
+    double t0 = now();
+    ArrayList<T> list;
+    for (int i=0; i<n; i++) list.append(make(i));
+    double t1 = now();
+    vector<T> vec;
+    for (int i=0; i<n; i++) vec.push_back(make(i));
+    double t2 = now();
+    if (list.length() != (int) vec.size()) cout << "size mismatch" << endl;
+    best_list = min(best_list, t1 - t0);
+    best_vector = min(best_vector, t2 - t1);
+  }
+  cout << setw(12) << left << name << setw(10) << n
+       << setw(16) << n/best_list << setw(16) << n/best_vector << endl;
+}
+
+void bench()
+{
+  cout << setw(12) << left << "type" << setw(10) << "n"
+       << setw(16) << "ArrayList/s" << setw(16) << "vector/s" << endl;
+  for (int n=1000; n<=10000000; n*=100) {
+    bench_append<int>("int", n, [](int i) { return i; });
+  }
+  for (int n=1000; n<=1000000; n*=10) {
+    bench_append<string>("string", n, [](int i) {
+      return string(24, 'a' + i%26);
+    });
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  // Timing appends against std::vector: ./array_list.x bench
+  if (argc > 1 and string(argv[1]) == "bench") {
+    bench();
+    return 0;
+  }
+
   cout << endl;
   cout << "---array_list.cpp---" << endl;
   cout << endl;
 
-  ArrayList A;
+  ArrayList<int> A;
 
   // Finding 10 primes
   int i = 1;
@@ -191,7 +367,7 @@ int main()
   A.print();
 
   // Testing overloaded constructor
-  ArrayList primes({2, 3, 5, 8, 11});
+  ArrayList<int> primes({2, 3, 5, 8, 11});
   primes.print();
 
   // Testing insert method
@@ -210,5 +386,12 @@ int main()
   cout << primes.pop() << " ";
   primes.print();
 
+  // Testing copy and move
+  ArrayList<int> copy(primes);
+  copy.append(13);
+  ArrayList<int> moved(move(copy));
+  cout << moved.length() << " " << copy.length() << " ";
+  moved.print();
+
   return 0;
 }
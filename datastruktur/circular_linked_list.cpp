@@ -1,8 +1,12 @@
 #include <iostream>
 #include <iomanip>
+#include <chrono>
 #include <cmath>
+#include <iterator>
+#include <string>
 #include <stdexcept>
 #include <vector>
+#include "node_pool.h"
 
 using namespace std;
 
@@ -27,12 +31,53 @@ struct Node
 };
 
 
+// The nodes come from a Pool, NodePool<Node> or HeapNodes<Node>, see
+// node_pool.h
+template <class Pool = NodePool<Node> >
 class CircLinkedList
 {
 private:
   Node* head;
   Node* tail;
   int size;
+  Pool pool;
+
+  // Freeing every node and leaving the list empty; a NodePool frees all
+  // its slabs at once
+  void release()
+  {
+    if (Pool::releases_nodes) {
+      pool.clear();
+    } else {
+      for (int i=0; i<size; i++) {
+        Node* next = head->next;
+        pool.destroy(head);
+        head = next;
+      }
+    }
+    head = nullptr;
+    tail = nullptr;
+    size = 0;
+  }
+
+  // Replacing the contents by the n values value(0), .., value(n-1),
+  // linked in one pass through nodes adjacent in memory
+  template <class Value>
+  void build(int n, Value value)
+  {
+    release();
+    if (n <= 0) {
+      return;
+    }
+    pool.reserve(n);
+    head = tail = pool.create(value(0));
+    for (int i=1; i<n; i++) {
+      tail->next = pool.create(value(i));
+      tail = tail->next;
+    }
+    tail->next = head;
+    size = n;
+  }
 
 public:
   // Basic constructor
@@ -40,37 +85,59 @@ public:
   {
     size = 0;
     head = nullptr;
+    tail = nullptr;
   }
 
-  // Overloaded constructor
-  CircLinkedList(int n)
+  // Overloaded constructor: the ring 1, 2, .., n
+  CircLinkedList(int n) : CircLinkedList()
   {
-    head = nullptr;
-    for (int i=1; i<=n; i++) {
-      append(i);
-    }
-    size = n;
+    build(n, [](int i) { return i + 1; });
+  }
+
+  // Ring with the values in [first, last)
+  template <class Iterator>
+  CircLinkedList(Iterator first, Iterator last) : CircLinkedList()
+  {
+    assign(first, last);
+  }
+
+  // The nodes belong to the pool, so the ring is not copied
+  CircLinkedList(const CircLinkedList&) = delete;
+  CircLinkedList& operator=(const CircLinkedList&) = delete;
+
+  // Destructor to free memory
+  ~CircLinkedList()
+  {
+    release();
+  }
+
+  // Replacing the contents by the values in [first, last)
+  template <class Iterator>
+  void assign(Iterator first, Iterator last)
+  {
+    int n = distance(first, last);
+    build(n, [&first](int) { return *first++; });
+  }
+
+  // Getting number of elements in list
+  int length()
+  {
+    return size;
   }
 
-  // Appending element to end of list
+  // Appending element to end of list in O(1), using the tail
   void append(int val)
   {
     // if empty list: insert value and point at iself
     if (head == nullptr) {
-      head = new Node(val, head);
+      head = pool.create(val);
+      head->next = head;
+      tail = head;
       size = 1;
       return;
     }
-    Node* last = new Node(val, head);
-    Node* current = head;
-
-    // If two or more elements in list: cycle until end of list
-    if (size > 1) {
-      while (current->next != head) {
-        current = current->next;
-      }
-    }
-    current->next = last;
+    tail->next = pool.create(val, head);
+    tail = tail->next;
     size += 1;
   }
 
@@ -90,6 +157,10 @@ public:
   // Printing elements in list once on a single line
   void print()
   {
+    if (head == nullptr) {
+      cout << "[]" << endl;
+      return;
+    }
     Node* current = head;
     cout << "[";
     while (current->next != head) {
@@ -100,52 +171,221 @@ public:
     cout << current->value << ", ...]" << endl;
   }
 
-  // Finding the Josephus Sequence
+  // Finding the Josephus Sequence: counting from the head, every k'th
+  // element is removed until the list is empty. Costs O(n k).
   vector<int> josephus_sequence(int k)
   {
-    Node* current = nullptr;
-    Node* prev;
-    Node* temp;
     vector<int> seq;
+    if (head == nullptr) {
+      return seq;
+    }
+    Node* prev = tail;
+    Node* current = head;
     while (size != 0) {
 
       // Iterating over k elements
-      for (int i=0; i<k; i++) {
-
-        // Starting iterations at first element
-        if (current == nullptr) {
-          current = head;
-          continue;
-        }
-        temp = current;
+      for (int i=1; i<k; i++) {
+        prev = current;
         current = current->next;
-        prev = temp;
       }
       seq.push_back(current->value);
-      prev->next = current->next;
-      delete current;
       size -= 1;
+      Node* next = current->next;
+      prev->next = next;
+      pool.destroy(current);
+      current = next;
+    }
+    head = nullptr;
+    tail = nullptr;
+    return seq;
+  }
+};
+
+/*
+Josephus problem for n people numbered 1 to n without a linked list. A
+Fenwick tree over the flat array of people counts how many are left in
+each prefix, so the person at a given rank among those left is found by
+descending the tree in O(log n), and the whole elimination order costs
+O(n log n) instead of O(n k).
+*/
+class Josephus
+{
+private:
+  int n;
+  int top;              // largest power of two not above n
+  vector<int> tree;     // tree[i] counts the people left in (i - lowbit(i), i]
+
+public:
+  Josephus(int n_) : n(n_), top(1), tree(n_ + 1)
+  {
+    while (2*top <= n) {
+      top *= 2;
+    }
+  }
+
+  // Order in which the people are removed when every k'th is
+  vector<int> sequence(int k)
+  {
+    // Everybody present: each node counts its own range, built in O(n)
+    for (int i=1; i<=n; i++) {
+      tree[i] = i & -i;
+    }
+    vector<int> seq;
+    seq.reserve(n);
+    long rank = 0;
+    for (int left=n; left>0; left--) {
+      rank = (rank + k - 1) % left;
+      int person = find(rank + 1);
+      seq.push_back(person);
+      for (int i=person; i<=n; i+=i&-i) {
+        tree[i] -= 1;
+      }
     }
     return seq;
   }
+
+private:
+  // Position of the r'th person still present
+  int find(long r)
+  {
+    int pos = 0;
+    for (int step=top; step>0; step/=2) {
+      if (pos + step <= n and tree[pos + step] < r) {
+        pos += step;
+        r -= tree[pos];
+      }
+    }
+    return pos + 1;
+  }
 };
 
+/*
+Only the survivor of n people when every k'th is removed, numbered from
+1. Removing a whole round of n/k people at a time reduces the problem to
+n - n/k people, so with k < n this costs O(k log n); the last few people
+use the recurrence J(m) = (J(m-1) + k) mod m in O(k).
+*/
+long josephus_survivor(long n, long k)
+{
+  if (k == 1) {
+    return n;
+  }
+  vector<long> rounds;
+  while (n >= k) {
+    rounds.push_back(n);
+    n -= n/k;
+  }
+  long res = 0;           // 0-based survivor of the m people left
+  for (long m=2; m<=n; m++) {
+    res = (res + k) % m;
+  }
+  for (int r=rounds.size()-1; r>=0; r--) {
+    long m = rounds[r];
+    res -= m % k;
+    if (res < 0) {
+      res += m;
+    } else {
+      res += res/(k - 1);
+    }
+  }
+  return res + 1;
+}
+
 // Function for solving the Josephus problem
 int last_man_standing(int n, int k)
 {
-  CircLinkedList list(n);
+  CircLinkedList<> list(n);
   vector<int> sequence = list.josephus_sequence(k);
   return sequence.back();
 }
 
+// Seconds since an arbitrary fixed point
+double now()
+{
+  using namespace chrono;
+  return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Seconds to build a ring of n elements with the bulk constructor, with
+// append, with append and one new per node, and with assign() from a
+// vector
+void bench_build()
+{
+  cout << setw(12) << left << "n" << setw(16) << "bulk [s]"
+       << setw(16) << "append [s]" << setw(16) << "new [s]"
+       << setw(16) << "assign [s]" << endl;
+  for (int n=1000; n<=10000000; n*=10) {
+    double t0 = now();
+    CircLinkedList<> bulk(n);
+    double t1 = now();
+    CircLinkedList<> appended;
+    for (int i=1; i<=n; i++) {
+      appended.append(i);
+    }
+    double t2 = now();
+    CircLinkedList<HeapNodes<Node> > heap;
+    for (int i=1; i<=n; i++) {
+      heap.append(i);
+    }
+    double t5 = now();
+    vector<int> values(n);
+    for (int i=0; i<n; i++) {
+      values[i] = i + 1;
+    }
+    double t3 = now();
+    CircLinkedList<> assigned;
+    assigned.assign(values.begin(), values.end());
+    double t4 = now();
+    if (bulk[n-1] != n or appended[n-1] != n or heap[n-1] != n
+        or assigned[n-1] != n) {
+      cout << "wrong ring for n = " << n << endl;
+    }
+    cout << setw(12) << n << setw(16) << t1 - t0 << setw(16) << t2 - t1
+         << setw(16) << t5 - t2 << setw(16) << t4 - t3 << endl;
+  }
+}
+
+// Seconds for the full elimination order with the linked list and with
+// the Fenwick tree, and for the survivor alone, with k = 7
+void bench()
+{
+  bench_build();
+  cout << endl;
+
+  int k = 7;
+  cout << setw(12) << left << "n" << setw(16) << "list [s]"
+       << setw(16) << "Fenwick [s]" << setw(16) << "survivor [s]"
+       << "survivor" << endl;
+  for (int n=1000; n<=10000000; n*=10) {
+    double t0 = now();
+    int last = last_man_standing(n, k);
+    double t1 = now();
+    Josephus josephus(n);
+    vector<int> seq = josephus.sequence(k);
+    double t2 = now();
+    long survivor = josephus_survivor(n, k);
+    double t3 = now();
+    if (survivor != seq.back() or last != survivor) {
+      cout << "mismatch for n = " << n << endl;
+    }
+    cout << setw(12) << n << setw(16) << t1 - t0 << setw(16) << t2 - t1
+         << setw(16) << t3 - t2 << survivor << endl;
+  }
+}
 
-int main()
+int main(int argc, char* argv[])
 {
+  // Timing the Josephus solvers: ./circular_linked_list.x bench
+  if (argc > 1 and string(argv[1]) == "bench") {
+    bench();
+    return 0;
+  }
+
   cout << endl;
   cout << "---circular_linked_list.cpp---" << endl;
   cout << endl;
 
-  CircLinkedList clist;
+  CircLinkedList<> clist;
   cout << setw(20) << left << "CircLinkedList clist;" << endl;
   clist.append(0); cout << "clist.append(0);" << endl;
   clist.append(2); cout << "clist.append(2);" << endl;
@@ -157,6 +397,7 @@ int main()
 
   cout << endl;
   cout << "L(68, 7) = " << last_man_standing(68, 7) << endl;
+  cout << "L(10^7, 7) = " << josephus_survivor(10000000, 7) << endl;
   cout << endl;
   
   return 0;
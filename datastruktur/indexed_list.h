@@ -0,0 +1,251 @@
+// A list with the interface of LinkedList in linked_list.cpp where every
+// operation by index takes O(log n) expected time. The elements are kept
+// in order in a treap, a binary tree balanced by random priorities, and
+// every node stores the size of its subtree, so an index is found by
+// comparing it with the sizes of the left subtrees on the way down.
+// Inserting and removing split the tree at an index and merge the parts
+// again.
+
+#ifndef INDEXED_LIST_H
+#define INDEXED_LIST_H
+
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "node_pool.h"
+
+class IndexedList
+{
+private:
+  struct TreeNode
+  {
+    int value;
+    unsigned priority;    // larger than those of all nodes below
+    int size;             // nodes in the subtree
+    TreeNode* left;
+    TreeNode* right;
+
+    TreeNode(int n, unsigned p)
+    {
+      value = n;
+      priority = p;
+      size = 1;
+      left = nullptr;
+      right = nullptr;
+    }
+  };
+
+  TreeNode* root;
+  TreeNode* last;
+  NodePool<TreeNode> pool;
+  std::mt19937 priorities;   // fixed seed, so runs can be repeated
+
+  // A seed unlikely to be shared with the caller's own generator, since
+  // priorities drawn in step with the positions would unbalance the tree
+  static const unsigned seed = 0x9e3779b9;
+
+  static int size_of(TreeNode* node)
+  {
+    return node == nullptr ? 0 : node->size;
+  }
+
+  static void update(TreeNode* node)
+  {
+    node->size = 1 + size_of(node->left) + size_of(node->right);
+  }
+
+  // Splitting tree into the first count elements in left and the rest
+  // in right
+  static void split(TreeNode* tree, int count, TreeNode*& left, TreeNode*& right)
+  {
+    if (tree == nullptr) {
+      left = nullptr;
+      right = nullptr;
+      return;
+    }
+    if (size_of(tree->left) < count) {
+      split(tree->right, count - size_of(tree->left) - 1, tree->right, right);
+      left = tree;
+    } else {
+      split(tree->left, count, left, tree->left);
+      right = tree;
+    }
+    update(tree);
+  }
+
+  // The elements of left followed by those of right
+  static TreeNode* merge(TreeNode* left, TreeNode* right)
+  {
+    if (left == nullptr) {
+      return right;
+    }
+    if (right == nullptr) {
+      return left;
+    }
+    if (left->priority > right->priority) {
+      left->right = merge(left->right, right);
+      update(left);
+      return left;
+    }
+    right->left = merge(left, right->left);
+    update(right);
+    return right;
+  }
+
+  // Getting node at given index
+  TreeNode* get_node(int index)
+  {
+    if (index < 0 or index >= size_of(root)) {
+      throw std::out_of_range("IndexError");
+    }
+    if (index == root->size - 1) {
+      return last;
+    }
+
+    TreeNode* current = root;
+    while (index != size_of(current->left)) {
+      if (index < size_of(current->left)) {
+        current = current->left;
+      } else {
+        index -= size_of(current->left) + 1;
+        current = current->right;
+      }
+    }
+    return current;
+  }
+
+  // Rightmost node of a tree
+  static TreeNode* rightmost(TreeNode* tree)
+  {
+    while (tree != nullptr and tree->right != nullptr) {
+      tree = tree->right;
+    }
+    return tree;
+  }
+
+public:
+  // Constructor for empty list
+  IndexedList() : priorities(seed)
+  {
+    root = nullptr;
+    last = nullptr;
+  }
+
+  // Overloaded constructor to initialize list with elements
+  IndexedList(std::vector<int> initial) : priorities(seed)
+  {
+    root = nullptr;
+    last = nullptr;
+
+    pool.reserve(initial.size());
+    for (int val: initial) {
+      append(val);
+    }
+  }
+
+  // The nodes belong to the pool, so lists are not copied
+  IndexedList(const IndexedList&) = delete;
+  IndexedList& operator=(const IndexedList&) = delete;
+
+  // Getting number of elements in list
+  int length()
+  {
+    return size_of(root);
+  }
+
+  // Adding new element to end of list
+  void append(int val)
+  {
+    last = pool.create(val, priorities());
+    root = merge(root, last);
+  }
+
+  // Printing elements on single line
+  void print()
+  {
+    std::cout << "[";
+    bool first = true;
+    traverse([&first](int val) {
+      std::cout << (first ? "" : ", ") << val;
+      first = false;
+    });
+    std::cout << "]" << std::endl;
+  }
+
+  // Calling f(value) for every element in order
+  template <class F>
+  void traverse(F f)
+  {
+    std::vector<TreeNode*> above;
+    TreeNode* current = root;
+    while (current != nullptr or not above.empty()) {
+      while (current != nullptr) {
+        above.push_back(current);
+        current = current->left;
+      }
+      current = above.back();
+      above.pop_back();
+      f(current->value);
+      current = current->right;
+    }
+  }
+
+  // Overloading []-operator to access element by index
+  int& operator[](int index)
+  {
+    return get_node(index)->value;
+  }
+
+  // Inserting element into list at given index, 0 <= index <= length()
+  void insert(int val, int index)
+  {
+    if (index < 0 or index > length()) {
+      throw std::out_of_range("IndexError");
+    }
+    if (index == length()) {
+      append(val);
+      return;
+    }
+
+    TreeNode* left;
+    TreeNode* right;
+    split(root, index, left, right);
+    root = merge(merge(left, pool.create(val, priorities())), right);
+  }
+
+  // Removing element at given index
+  void remove(int index)
+  {
+    if (index < 0 or index >= length()) {
+      throw std::out_of_range("IndexError");
+    }
+
+    TreeNode* left;
+    TreeNode* middle;
+    TreeNode* right;
+    split(root, index, left, right);
+    split(right, 1, middle, right);
+    pool.destroy(middle);
+    root = merge(left, right);
+    if (right == nullptr) {
+      last = rightmost(root);
+    }
+  }
+
+  // Removing element at given index and returning it
+  int pop(int index)
+  {
+    int temp = get_node(index)->value;
+    remove(index);
+    return temp;
+  }
+
+  // Overloading pop if no given index: pops last element
+  int pop()
+  {
+    return pop(length()-1);
+  }
+};
+
+#endif
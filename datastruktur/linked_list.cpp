@@ -5,6 +5,12 @@
 #include <cmath>
 #include <stdexcept>
 #include <vector>
+#include <chrono>
+#include <string>
+#include <random>
+#include "node_pool.h"
+#include "unrolled_linked_list.h"
+#include "indexed_list.h"
 
 using namespace std;
 
@@ -29,18 +35,25 @@ struct Node
 };
 
 
+// The nodes come from a Pool, NodePool<Node> or HeapNodes<Node>, see
+// node_pool.h
+template <class Pool = NodePool<Node> >
 class LinkedList
 {
 private:
   Node* head;
   Node* tail;
   int size;
+  Pool pool;
 
   // Getting node at given index
   Node* get_node(int index) {
     if (index < 0 or index >= size) {
       throw out_of_range("IndexError");
     }
+    if (index == size-1) {
+      return tail;
+    }
 
     Node* current = head;
     for (int i=0; i<index; i++) {
@@ -63,7 +76,9 @@ public:
   {
     size = 0;
     head = nullptr;
+    tail = nullptr;
 
+    pool.reserve(initial.size());
     for (int val: initial) {
       append(val);
     }
@@ -81,12 +96,12 @@ public:
     size += 1;
 
     if (head == nullptr) {
-      head = new Node(val);
+      head = pool.create(val);
       tail = head;
       return;
     }
 
-    tail->next = new Node(val);
+    tail->next = pool.create(val);
     tail = tail->next;
   }
 
@@ -103,9 +118,17 @@ public:
     cout << current->value << "]" << endl;
   }
 
-  // Destructor to free memory
+  // The nodes belong to the pool, so lists are not copied
+  LinkedList(const LinkedList&) = delete;
+  LinkedList& operator=(const LinkedList&) = delete;
+
+  // Destructor to free memory; a NodePool frees all nodes by itself
   ~LinkedList()
   {
+    if (Pool::releases_nodes) {
+      return;
+    }
+
     Node* current;
     Node* next;
 
@@ -113,23 +136,44 @@ public:
 
     while (current != nullptr) {
       next = current->next;
-      delete current;
+      pool.destroy(current);
       current = next;
     }
   }
 
+  // Calling f(value) for every element in order
+  template <class F>
+  void traverse(F f)
+  {
+    for (Node* current=head; current!=nullptr; current=current->next) {
+      f(current->value);
+    }
+  }
+
   // Overloading []-operator to access element by index
   int& operator[](int index)
   {
     return get_node(index)->value;
   }
 
-  // Inserting element into list at given index
+  // Inserting element into list at given index, 0 <= index <= length()
   void insert(int val, int index)
   {
+    if (index == 0) {
+      head = pool.create(val, head);
+      if (tail == nullptr) {
+        tail = head;
+      }
+      size += 1;
+      return;
+    }
+
     Node* prev = get_node(index-1);
     Node* next = prev->next;
-    prev->next = new Node(val, next);
+    prev->next = pool.create(val, next);
+    if (prev == tail) {
+      tail = prev->next;
+    }
 
     size += 1;
   }
@@ -137,10 +181,27 @@ public:
   // Removing element at given index
   void remove(int index)
   {
+    if (index == 0 and size > 0) {
+      Node* current = head;
+      head = head->next;
+      if (current == tail) {
+        tail = nullptr;
+      }
+      pool.destroy(current);
+      size -= 1;
+      return;
+    }
+
     Node* prev = get_node(index-1);
-    Node* current = get_node(index);
+    Node* current = prev->next;
+    if (current == nullptr) {
+      throw out_of_range("IndexError");
+    }
     prev->next = current->next;
-    delete current;
+    if (current == tail) {
+      tail = prev;
+    }
+    pool.destroy(current);
 
     size -= 1;
   }
@@ -153,23 +214,174 @@ public:
     return temp;
   }
 
-  // Overloading pop if no given index: pops last element
+  // Overloading pop if no given index: pops last element. The value is
+  // read at the tail, but the node before it is still found by walking
   int pop()
   {
-    int temp = get_node(size-1)->value;
+    if (size == 0) {
+      throw out_of_range("IndexError");
+    }
+    int temp = tail->value;
     remove(size-1);
     return temp;
   }
 };
 
+// The list used by the examples in main(), chosen when compiling:
+//   -DLIST_UNROLLED  blocks of values, see unrolled_linked_list.h
+//   -DLIST_INDEXED   O(log n) operations by index, see indexed_list.h
+// and the singly linked list above otherwise
+#if defined(LIST_INDEXED)
+typedef IndexedList List;
+#elif defined(LIST_UNROLLED)
+typedef UnrolledLinkedList<> List;
+#else
+typedef LinkedList<> List;
+#endif
+
+// Seconds since an arbitrary fixed point
+double now()
+{
+  using namespace chrono;
+  return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Millions of elements per second appended, traversed and removed from
+// the front, for a list of n elements with nodes from the Pool
+template <class Pool>
+void bench_pool(string name, int n)
+{
+  double t0 = now();
+  LinkedList<Pool>* list = new LinkedList<Pool>;
+  for (int i=0; i<n; i++) {
+    list->append(i);
+  }
+  double t1 = now();
+  long sum = 0;
+  list->traverse([&sum](int val) { sum += val; });
+  double t2 = now();
+  while (list->length() > 1) {
+    list->remove(1);
+  }
+  double t3 = now();
+  delete list;
+  double t4 = now();
+  if (sum != (long) n*(n - 1)/2) {
+    cout << "wrong sum" << endl;
+  }
+  cout << setw(12) << left << name << setw(10) << n
+       << setw(12) << 1e-6*n/(t1 - t0) << setw(12) << 1e-6*n/(t2 - t1)
+       << setw(12) << 1e-6*n/(t3 - t2) << setw(12) << t4 - t3 << endl;
+}
 
-int main()
+// Microseconds per operator[] and per insert at random positions in a
+// List of n elements, ops of each; the sum of the values read is returned
+// so that lists can be checked against each other
+template <class ListType>
+long bench_positional(string name, int n, int ops)
 {
+  ListType list;
+  for (int i=0; i<n; i++) {
+    list.append(i);
+  }
+
+  mt19937 rng(2020);
+  long sum = 0;
+  double t0 = now();
+  for (int k=0; k<ops; k++) {
+    sum += list[uniform_int_distribution<int>(0, n-1)(rng)];
+  }
+  double t1 = now();
+  for (int k=0; k<ops; k++) {
+    list.insert(-k, uniform_int_distribution<int>(0, list.length())(rng));
+  }
+  double t2 = now();
+  list.traverse([&sum](int val) { sum += val; });
+
+  cout << setw(16) << left << name << setw(10) << n << setw(8) << ops
+       << setw(14) << 1e6*(t1 - t0)/ops << setw(14) << 1e6*(t2 - t1)/ops
+       << endl;
+  return sum;
+}
+
+// Seconds to fill an empty ListType by n inserts at random positions and
+// then empty half of it by removes at random positions, with a checksum
+// of the values left as for bench_positional()
+template <class ListType>
+long bench_edits(string name, int n)
+{
+  ListType list;
+  mt19937 rng(2020);
+  double t0 = now();
+  for (int k=0; k<n; k++) {
+    list.insert(k, uniform_int_distribution<int>(0, list.length())(rng));
+  }
+  for (int k=0; k<n/2; k++) {
+    list.remove(uniform_int_distribution<int>(0, list.length()-1)(rng));
+  }
+  double t1 = now();
+  long sum = 0;
+  list.traverse([&sum](int val) { sum = 31*sum + val; });
+
+  cout << setw(16) << left << name << setw(10) << n << setw(14) << t1 - t0
+       << endl;
+  return sum;
+}
+
+void bench()
+{
+  cout << setw(16) << left << "list" << setw(10) << "n" << setw(8) << "ops"
+       << setw(14) << "[] [us]" << setw(14) << "insert [us]" << endl;
+  for (int n=100000; n<=10000000; n*=10) {
+    int ops = max(10, 100000000/n);
+    long a = bench_positional<LinkedList<> >("LinkedList", n, ops);
+    long b = bench_positional<UnrolledLinkedList<> >("Unrolled<12>", n, ops);
+    long c = bench_positional<UnrolledLinkedList<60> >("Unrolled<60>", n, ops);
+    long d = bench_positional<IndexedList>("IndexedList", n, ops);
+    if (a != b or a != c or a != d) {
+      cout << "lists differ" << endl;
+    }
+  }
+  cout << endl;
+
+  // Quadratic for the linked lists, which would take about a minute for
+  // LinkedList at 10^5 elements and UnrolledLinkedList at 10^6
+  cout << setw(16) << left << "list" << setw(10) << "n"
+       << setw(14) << "edits [s]" << endl;
+  for (int n=10000; n<=1000000; n*=10) {
+    long d = bench_edits<IndexedList>("IndexedList", n);
+    if (n <= 10000 and bench_edits<LinkedList<> >("LinkedList", n) != d) {
+      cout << "lists differ" << endl;
+    }
+    if (n <= 100000
+        and bench_edits<UnrolledLinkedList<> >("Unrolled<12>", n) != d) {
+      cout << "lists differ" << endl;
+    }
+  }
+  cout << endl;
+
+  cout << setw(12) << left << "nodes" << setw(10) << "n"
+       << setw(12) << "append" << setw(12) << "traverse"
+       << setw(12) << "remove" << setw(12) << "free [s]" << endl;
+  for (int n=1000; n<=10000000; n*=10) {
+    bench_pool<HeapNodes<Node> >("new/delete", n);
+    bench_pool<NodePool<Node> >("NodePool", n);
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  // Timing the lists and node allocators: ./linked_list.x bench
+  if (argc > 1 and string(argv[1]) == "bench") {
+    bench();
+    return 0;
+  }
+
   cout << endl;
   cout << "---linked_list.cpp---" << endl;
   cout << endl;
 
-  LinkedList A;
+  List A;
   cout << setw(20) << left << "LinkedList A;" << endl;
   A.append(1); cout << setw(20) << "A.append(1)"; A.print();
   A.append(2); cout << setw(20) << "A.append(2)"; A.print();
@@ -180,7 +392,7 @@ int main()
   cout << setw(20) << "A.pop()" << A.pop() << " "; A.print();
 
   cout << endl;
-  LinkedList B({5, 4, 3, 2, 1});
+  List B({5, 4, 3, 2, 1});
   cout << setw(20) << left << "LinkedList B({5, 4, 3, 2, 1});" << endl;
   cout << setw(20) << "B.print()"; B.print();
   cout << setw(20) << "B[2]" << B[2] << endl;
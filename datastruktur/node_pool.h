@@ -0,0 +1,134 @@
+// Allocators for the nodes of the linked lists. NodePool hands out nodes
+// from large slabs and keeps removed nodes on a free list for reuse, so
+// nodes appended one after another lie next to each other in memory and
+// the whole pool is freed with one deallocation per slab. HeapNodes does
+// one new and one delete per node, for comparison.
+
+#ifndef NODE_POOL_H
+#define NODE_POOL_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+template <class Node>
+class NodePool
+{
+private:
+  // A slot holds either a node or the link to the next free slot
+  union Slot
+  {
+    Slot* next_free;
+    typename std::aligned_storage<sizeof(Node), alignof(Node)>::type node;
+  };
+
+  std::vector<Slot*> slabs;
+  Slot* free_list;      // slots given back by destroy()
+  Slot* spare;          // slots never used at the end of the last slab
+  size_t spare_left;
+  size_t next_slab;     // size of the next slab, doubling each time
+
+  void new_slab(size_t n)
+  {
+    spare = static_cast<Slot*>(::operator new(n*sizeof(Slot)));
+    slabs.push_back(spare);
+    spare_left = n;
+  }
+
+public:
+  // The memory of the nodes goes with the pool, so a list need not
+  // destroy its nodes one by one when they have no destructor to run
+  static const bool releases_nodes = std::is_trivially_destructible<Node>::value;
+
+  NodePool(size_t first_slab = 64)
+  {
+    free_list = nullptr;
+    spare = nullptr;
+    spare_left = 0;
+    next_slab = first_slab > 0 ? first_slab : 1;
+  }
+
+  NodePool(const NodePool&) = delete;
+  NodePool& operator=(const NodePool&) = delete;
+
+  ~NodePool()
+  {
+    clear();
+  }
+
+  // Freeing all slabs; every node handed out becomes invalid
+  void clear()
+  {
+    for (Slot* slab: slabs) {
+      ::operator delete(slab);
+    }
+    slabs.clear();
+    free_list = nullptr;
+    spare = nullptr;
+    spare_left = 0;
+  }
+
+  // Making the next n nodes from create() adjacent in memory, unless
+  // freed nodes are reused first
+  void reserve(size_t n)
+  {
+    if (spare_left < n) {
+      new_slab(n);
+    }
+  }
+
+  // A new node constructed from args, from the free list if possible
+  template <class... Args>
+  Node* create(Args&&... args)
+  {
+    Slot* slot;
+    if (free_list != nullptr) {
+      slot = free_list;
+      free_list = free_list->next_free;
+    } else {
+      if (spare_left == 0) {
+        new_slab(next_slab);
+        next_slab *= 2;
+      }
+      slot = spare++;
+      spare_left -= 1;
+    }
+    return new (&slot->node) Node(std::forward<Args>(args)...);
+  }
+
+  // Destroying a node from create() and keeping its slot for reuse
+  void destroy(Node* node)
+  {
+    node->~Node();
+    Slot* slot = reinterpret_cast<Slot*>(node);
+    slot->next_free = free_list;
+    free_list = slot;
+  }
+};
+
+template <class Node>
+class HeapNodes
+{
+public:
+  static const bool releases_nodes = false;
+
+  // Nothing is kept here, so the lists destroy their nodes one by one
+  void clear() {}
+
+  void reserve(size_t) {}
+
+  template <class... Args>
+  Node* create(Args&&... args)
+  {
+    return new Node(std::forward<Args>(args)...);
+  }
+
+  void destroy(Node* node)
+  {
+    delete node;
+  }
+};
+
+#endif
@@ -0,0 +1,247 @@
+// An unrolled linked list: the same interface as LinkedList in
+// linked_list.cpp, but each node is a block holding up to B values with a
+// fill count. Finding an index skips a whole block per pointer, and
+// insert and remove shift values within one block, so positional
+// operations follow about n/B pointers instead of n. With the default B
+// a block fills one 64-byte cache line.
+
+#ifndef UNROLLED_LINKED_LIST_H
+#define UNROLLED_LINKED_LIST_H
+
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include "node_pool.h"
+
+template <int B = 12>
+class UnrolledLinkedList
+{
+private:
+  struct Block
+  {
+    Block* next;
+    int count;
+    int values[B];
+
+    Block()
+    {
+      next = nullptr;
+      count = 0;
+    }
+  };
+
+  Block* head;
+  Block* tail;
+  int size;
+  NodePool<Block> pool;
+
+  // Block holding the given index, the position within it in offset and
+  // the block before it in prev (nullptr for the head)
+  Block* get_block(int index, int& offset, Block*& prev)
+  {
+    if (index < 0 or index >= size) {
+      throw std::out_of_range("IndexError");
+    }
+
+    prev = nullptr;
+    Block* current = head;
+    while (index >= current->count) {
+      index -= current->count;
+      prev = current;
+      current = current->next;
+    }
+    offset = index;
+    return current;
+  }
+
+  // Moving the upper half of a full block into a new block after it
+  void split(Block* block)
+  {
+    Block* upper = pool.create();
+    int half = block->count/2;
+    for (int i=half; i<block->count; i++) {
+      upper->values[i - half] = block->values[i];
+    }
+    upper->count = block->count - half;
+    block->count = half;
+
+    upper->next = block->next;
+    block->next = upper;
+    if (block == tail) {
+      tail = upper;
+    }
+  }
+
+  // Unlinking and freeing the block after prev (the head if prev is null)
+  void unlink(Block* prev, Block* block)
+  {
+    if (prev == nullptr) {
+      head = block->next;
+    } else {
+      prev->next = block->next;
+    }
+    if (block == tail) {
+      tail = prev;
+    }
+    pool.destroy(block);
+  }
+
+public:
+  // Constructor for empty list: head and tail points at nullptr
+  UnrolledLinkedList()
+  {
+    size = 0;
+    head = nullptr;
+    tail = nullptr;
+  }
+
+  // Overloaded constructor to initialize list with elements
+  UnrolledLinkedList(std::vector<int> initial)
+  {
+    size = 0;
+    head = nullptr;
+    tail = nullptr;
+
+    pool.reserve((initial.size() + B - 1)/B);
+    for (int val: initial) {
+      append(val);
+    }
+  }
+
+  // The blocks belong to the pool, so lists are not copied
+  UnrolledLinkedList(const UnrolledLinkedList&) = delete;
+  UnrolledLinkedList& operator=(const UnrolledLinkedList&) = delete;
+
+  // Getting number of elements in list
+  int length()
+  {
+    return size;
+  }
+
+  // Adding new element to end of list, filling the last block first
+  void append(int val)
+  {
+    if (tail == nullptr or tail->count == B) {
+      Block* block = pool.create();
+      if (tail == nullptr) {
+        head = block;
+      } else {
+        tail->next = block;
+      }
+      tail = block;
+    }
+    tail->values[tail->count] = val;
+    tail->count += 1;
+    size += 1;
+  }
+
+  // Printing elements on single line
+  void print()
+  {
+    std::cout << "[";
+    bool first = true;
+    for (Block* block=head; block!=nullptr; block=block->next) {
+      for (int i=0; i<block->count; i++) {
+        if (not first) {
+          std::cout << ", ";
+        }
+        std::cout << block->values[i];
+        first = false;
+      }
+    }
+    std::cout << "]" << std::endl;
+  }
+
+  // Calling f(value) for every element in order
+  template <class F>
+  void traverse(F f)
+  {
+    for (Block* block=head; block!=nullptr; block=block->next) {
+      for (int i=0; i<block->count; i++) {
+        f(block->values[i]);
+      }
+    }
+  }
+
+  // Overloading []-operator to access element by index
+  int& operator[](int index)
+  {
+    if (index == size - 1 and tail != nullptr) {
+      return tail->values[tail->count - 1];
+    }
+    int offset;
+    Block* prev;
+    Block* block = get_block(index, offset, prev);
+    return block->values[offset];
+  }
+
+  // Inserting element into list at given index, 0 <= index <= length()
+  void insert(int val, int index)
+  {
+    if (index == size) {
+      append(val);
+      return;
+    }
+
+    int offset;
+    Block* prev;
+    Block* block = get_block(index, offset, prev);
+    if (block->count == B) {
+      split(block);
+      if (offset > block->count) {
+        offset -= block->count;
+        block = block->next;
+      }
+    }
+
+    for (int i=block->count; i>offset; i--) {
+      block->values[i] = block->values[i-1];
+    }
+    block->values[offset] = val;
+    block->count += 1;
+    size += 1;
+  }
+
+  // Removing element at given index. A block left less than half full
+  // takes in the next block when their values fit in one
+  void remove(int index)
+  {
+    int offset;
+    Block* prev;
+    Block* block = get_block(index, offset, prev);
+    for (int i=offset+1; i<block->count; i++) {
+      block->values[i-1] = block->values[i];
+    }
+    block->count -= 1;
+    size -= 1;
+
+    Block* next = block->next;
+    if (2*block->count < B and next != nullptr
+        and block->count + next->count <= B) {
+      for (int i=0; i<next->count; i++) {
+        block->values[block->count + i] = next->values[i];
+      }
+      block->count += next->count;
+      unlink(block, next);
+    }
+    if (block->count == 0) {
+      unlink(prev, block);
+    }
+  }
+
+  // Removing element at given index and returning it
+  int pop(int index)
+  {
+    int temp = (*this)[index];
+    remove(index);
+    return temp;
+  }
+
+  // Overloading pop if no given index: pops last element
+  int pop()
+  {
+    return pop(size-1);
+  }
+};
+
+#endif
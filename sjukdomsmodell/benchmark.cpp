@@ -0,0 +1,563 @@
+// Timing of the numerical kernels. Compile with optimisation, e.g.
+//   c++ -O3 -march=native -std=c++11 -pthread benchmark.cpp lib.cpp -o benchmark.x
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "lib.h"
+#include "interpolation.h"
+#include "matrix.h"
+#include "quadrature.h"
+#include "rk4.h"
+#include "roots.h"
+#include "rk4_batch.h"
+#include "trajectory_store.h"
+
+using namespace std;
+
+// Seconds since an arbitrary fixed point
+double now()
+{
+  using namespace chrono;
+  return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Right-hand side of one scenario in the batch, for the scalar path
+struct Scenario
+{
+  double N, b, c, d, dI, e;
+
+  void operator()(double t, const double* y, double* dydt) const {
+    double inf = SIRSBatch::a(t)*y[0]*y[1]/N;
+    dydt[0] = c*y[2] - inf - d*y[0] + e*N;
+    dydt[1] = inf - b*y[1] - d*y[1] - dI*y[1];
+    dydt[2] = b*y[1] - c*y[2] - d*y[1];
+  }
+};
+
+// Scenarios times steps per second for the batched RK4 integrator
+void bench_rk4_batch()
+{
+  int nscen = 4096;
+  int steps = 1000;
+  double h = 0.1;
+
+  SIRSBatch batch;
+  for (int j=0; j<nscen; j++) {
+    batch.add(300, 100, 0, 1 + j%4, 0.5, 0.6 + 0.0001*j, 1.0 + 0.0002*j);
+  }
+  vector<Scenario> scen(nscen);
+  vector<double> y(3*nscen);
+  for (int j=0; j<nscen; j++) {
+    Scenario s = {batch.N[j], batch.b[j], batch.c[j], batch.d[j],
+                  batch.dI[j], batch.e[j]};
+    scen[j] = s;
+    y[3*j] = batch.S[j]; y[3*j+1] = batch.I[j]; y[3*j+2] = batch.R[j];
+  }
+  SIRSBatch scalar = batch;
+
+  double t0 = now();
+  for (int j=0; j<nscen; j++) {
+    for (int k=0; k<steps; k++) rk4_step<3>(&y[3*j], k*h, h, scen[j]);
+  }
+  double t1 = now();
+  for (int k=0; k<steps; k++) scalar.step_lanes<ScalarLanes>(k*h, h);
+  double t2 = now();
+  for (int k=0; k<steps; k++) batch.step(k*h, h);
+  double t3 = now();
+
+  double diff = 0.0;
+  for (int j=0; j<nscen; j++) {
+    diff = max(diff, fabs(batch.S[j] - y[3*j]) + fabs(batch.I[j] - y[3*j+1]));
+  }
+
+  double work = (double) nscen*steps;
+  cout << "rk4 batch, " << nscen << " scenarios x " << steps << " steps" << endl;
+  cout << setw(30) << left << "  rk4_step<3> per scenario" << work/(t1 - t0)
+       << " scenario-steps/s" << endl;
+  cout << setw(30) << "  SIRSBatch, scalar lanes" << work/(t2 - t1)
+       << " scenario-steps/s" << endl;
+  cout << setw(30) << "  SIRSBatch, native lanes" << work/(t3 - t2)
+       << " scenario-steps/s (width " << NativeLanes::width << ")" << endl;
+  cout << "  largest difference to rk4_step<3>: " << diff << endl;
+}
+
+// Allocations and peak memory of a sweep storing S, I, R per scenario,
+// first through a reused TrajectoryStore, then with new[] per array, all
+// held to the end as Population::initiate() used to leak them. They are
+// freed afterwards so that later benchmarks are not affected
+void bench_trajectory_store()
+{
+  int batches = 50;
+  int npops = 64;
+  int steps = 3650;
+
+  TrajectoryStore store;
+  double t0 = now();
+  for (int k=0; k<batches; k++) {
+    store.reset(npops, steps);
+    for (int p=0; p<npops; p++) {
+      double* block = store.take(3*steps);
+      for (int i=0; i<3*steps; i++) block[i] = i;
+    }
+  }
+  double t1 = now();
+  long rss_store = peak_rss_kb();
+
+  vector<double*> arrays;
+  arrays.reserve(3*batches*npops);
+  for (int k=0; k<batches; k++) {
+    for (int p=0; p<npops; p++) {
+      for (int c=0; c<3; c++) {
+        double* arr = new double[steps];
+        for (int i=0; i<steps; i++) arr[i] = i;
+        arrays.push_back(arr);
+      }
+    }
+  }
+  double t2 = now();
+  long rss_leak = peak_rss_kb();
+  for (size_t k=0; k<arrays.size(); k++) delete[] arrays[k];
+
+  cout << "trajectory store, " << batches << " batches x " << npops
+       << " populations x " << steps << " steps" << endl;
+  cout << setw(30) << left << "  TrajectoryStore" << store.allocations()
+       << " allocations, " << store.peak_bytes()/1024 << " KB held, peak RSS "
+       << rss_store << " KB, " << t1 - t0 << " s" << endl;
+  cout << setw(30) << "  new[] per array" << 3L*batches*npops
+       << " allocations, peak RSS " << rss_leak << " KB, " << t2 - t1
+       << " s" << endl;
+}
+// GFLOP/s of LU decomposition, 2n^3/3 flops, for the row-pointer ludcmp()
+// and the blocked contiguous one, and of the blocked lubksb() for n
+// right-hand sides, 2n^3 flops. The row-pointer version is only timed up
+// to n = 1024, beyond that it takes minutes.
+void bench_lu()
+{
+  cout << "LU decomposition, GFLOP/s" << endl;
+  cout << setw(8) << right << "n" << setw(16) << "ludcmp(**)" << setw(16)
+       << "ludcmp(*)" << setw(16) << "lubksb(*, n)" << setw(14)
+       << "residual" << endl;
+  for (int n=64; n<=4096; n*=2) {
+    Matrix a(n, n);
+    RowPointers rows(a);
+    vector<double> a0(n*(size_t) n), b(n*(size_t) n), b0(n*(size_t) n);
+    vector<int> indx(n);
+    double d;
+    long seed = -1;
+    for (size_t k=0; k<a0.size(); k++) a0[k] = ran2(&seed) - 0.5;
+    for (size_t k=0; k<b0.size(); k++) b0[k] = ran2(&seed) - 0.5;
+    double flops = 2.0*n*n*(double) n/3.0;
+
+    double gf_old = 0.0;
+    if (n <= 1024) {
+      memcpy(a.data(), a0.data(), 8*a0.size());
+      double t0 = now();
+      ludcmp(rows, n, indx.data(), &d);
+      gf_old = flops/(now() - t0)/1e9;
+    }
+
+    memcpy(a.data(), a0.data(), 8*a0.size());
+    b = b0;
+    double t0 = now();
+    ludcmp(a.data(), n, indx.data(), &d);
+    double t1 = now();
+    lubksb(a.data(), n, indx.data(), b.data(), n);
+    double t2 = now();
+
+    // Largest residual |A x - b| of the first right-hand side
+    double err = 0.0;
+    for (int i=0; i<n; i++) {
+      double r = -b0[i*(size_t) n];
+      for (int k=0; k<n; k++) r += a0[i*(size_t) n + k]*b[k*(size_t) n];
+      err = max(err, fabs(r));
+    }
+
+    cout << setw(8) << n << setw(16);
+    if (gf_old > 0) cout << gf_old; else cout << "-";
+    cout << setw(16) << flops/(t1 - t0)/1e9 << setw(16)
+         << 3*flops/(t2 - t1)/1e9 << setw(14) << err << endl;
+  }
+}
+// Time of the serial row-pointer jacobi() and of the round-robin one on
+// contiguous storage for 1, 2, 4 and 8 threads, for a random symmetric
+// matrix
+void bench_jacobi()
+{
+  int n = 400;
+  vector<double> a0(n*n), a(n*n), d(n), v(n*n);
+  long seed = -1;
+  for (int i=0; i<n; i++) {
+    for (int j=0; j<=i; j++) a0[i*n + j] = a0[j*n + i] = ran2(&seed) - 0.5;
+  }
+  cout << "jacobi, n = " << n << ", " << thread::hardware_concurrency()
+       << " hardware threads" << endl;
+
+  double** A = (double**) matrix(n, n, sizeof(double));
+  double** V = (double**) matrix(n, n, sizeof(double));
+  memcpy(A[0], a0.data(), 8*a0.size());
+  int nrot;
+  double t0 = now();
+  int status = jacobi(A, d.data(), V, n, nrot);
+  double serial = now() - t0;
+  cout << setw(30) << left << "  jacobi(**)" << serial << " s, " << nrot
+       << " rotations, status " << status << endl;
+  free_matrix((void**) A);
+  free_matrix((void**) V);
+
+  for (int nthreads=1; nthreads<=8; nthreads*=2) {
+    a = a0;
+    t0 = now();
+    status = jacobi(a.data(), d.data(), v.data(), n, nrot, nthreads);
+    double t = now() - t0;
+    cout << "  jacobi(*), " << setw(18) << left << to_string(nthreads) + " threads"
+         << t << " s, " << nrot << " rotations, status " << status
+         << ", speedup " << serial/t << endl;
+  }
+}
+// Seconds for all eigenvalues and eigenvectors of random symmetric
+// matrices by jacobi() and by Householder reduction followed by QL, with
+// the row-pointer and the blocked contiguous tred2()/tqli(), and for the
+// eigenvalues alone. jacobi() is only run up to n = 400.
+void bench_eigen()
+{
+  cout << "symmetric eigenproblem, seconds" << endl;
+  cout << setw(8) << right << "n" << setw(12) << "jacobi(*)" << setw(14)
+       << "tred2(**)" << setw(12) << "tred2(*)" << setw(14) << "values only"
+       << setw(14) << "difference" << endl;
+  for (int n=100; n<=800; n*=2) {
+    vector<double> a0(n*n), a(n*n), v(n*n), d(n), e(n), dj(n);
+    long seed = -1;
+    for (int i=0; i<n; i++) {
+      for (int j=0; j<=i; j++) a0[i*n + j] = a0[j*n + i] = ran2(&seed) - 0.5;
+    }
+    int nrot;
+    double t_jacobi = 0.0;
+    if (n <= 400) {
+      a = a0;
+      double t0 = now();
+      jacobi(a.data(), dj.data(), v.data(), n, nrot);
+      t_jacobi = now() - t0;
+      sort(dj.begin(), dj.end());
+    }
+
+    double** A = (double**) matrix(n, n, sizeof(double));
+    memcpy(A[0], a0.data(), 8*a0.size());
+    double t0 = now();
+    tred2(A, n, d.data(), e.data());
+    tqli(d.data(), e.data(), n, A);
+    double t1 = now();
+    free_matrix((void**) A);
+
+    a = a0;
+    double t2 = now();
+    tred2(a.data(), n, d.data(), e.data());
+    tqli(d.data(), e.data(), n, a.data());
+    double t3 = now();
+    sort(d.begin(), d.end());
+    double diff = 0.0;
+    for (int i=0; i<n && n<=400; i++) diff = max(diff, fabs(d[i] - dj[i]));
+
+    a = a0;
+    double t4 = now();
+    tred2(a.data(), n, d.data(), e.data(), 0);
+    tqli(d.data(), e.data(), n, (double*) 0);
+    double t5 = now();
+
+    cout << setw(8) << n << setw(12);
+    if (n <= 400) cout << t_jacobi; else cout << "-";
+    cout << setw(14) << t1 - t0 << setw(12) << t3 - t2 << setw(14) << t5 - t4
+         << setw(14);
+    if (n <= 400) cout << diff << endl; else cout << "-" << endl;
+  }
+}
+// Integrand for the quadrature benchmark, Runge's function, on one point
+// and on an array
+double runge(double x)
+{
+  return 1.0/(1.0 + 25.0*x*x);
+}
+
+void runge_batch(const double* x, double* y, size_t count)
+{
+  for (size_t i=0; i<count; i++) y[i] = 1.0/(1.0 + 25.0*x[i]*x[i]);
+}
+
+// Integrals per second of a 16-point Gauss-Legendre rule over many
+// intervals, with gauleg() per interval, with GaussLegendre one interval
+// at a time and in batches, with the integrand inlined and behind a
+// function pointer, and the one-off cost of a table
+void bench_quadrature()
+{
+  int n = 16;
+  size_t m = 200000;
+  vector<double> a(m), b(m), r1(m), r2(m), r3(m), x(n), w(n);
+  for (size_t k=0; k<m; k++) {
+    a[k] = -2.0 + 1e-5*k;
+    b[k] = a[k] + 1.0;
+  }
+
+  double t0 = now();
+  for (size_t k=0; k<m; k++) {
+    gauleg(a[k], b[k], x.data(), w.data(), n);
+    double sum = 0.0;
+    for (int i=0; i<n; i++) sum += w[i]*runge(x[i]);
+    r1[k] = sum;
+  }
+  double t1 = now();
+  GaussLegendre rule(n);
+  for (size_t k=0; k<m; k++) r2[k] = rule.integrate(runge, a[k], b[k]);
+  double t2 = now();
+  rule.integrate(runge_batch, a.data(), b.data(), m, r3.data());
+  double t3 = now();
+  double (* volatile opaque)(double) = runge;   // cannot be inlined
+  double (*f)(double) = opaque;
+  for (size_t k=0; k<m; k++) r2[k] = rule.integrate(f, a[k], b[k]);
+  double t5 = now();
+  void (* volatile opaque_batch)(const double*, double*, size_t) = runge_batch;
+  void (*fb)(const double*, double*, size_t) = opaque_batch;
+  rule.integrate(fb, a.data(), b.data(), m, r3.data());
+  double t6 = now();
+  gauleg_table(2000);
+  double t4 = now();
+
+  double diff = 0.0;
+  for (size_t k=0; k<m; k++) {
+    diff = max(diff, max(fabs(r1[k] - r2[k]), fabs(r1[k] - r3[k])));
+  }
+  cout << "Gauss-Legendre, " << m << " intervals x " << n << " points" << endl;
+  cout << setw(30) << left << "  gauleg() per interval" << m/(t1 - t0)
+       << " integrals/s" << endl;
+  cout << setw(30) << "  GaussLegendre, one by one" << m/(t2 - t1)
+       << " integrals/s" << endl;
+  cout << setw(30) << "  GaussLegendre, batched" << m/(t3 - t2)
+       << " integrals/s" << endl;
+  cout << setw(30) << "  pointer, one by one" << m/(t5 - t3)
+       << " integrals/s" << endl;
+  cout << setw(30) << "  pointer, batched" << m/(t6 - t5)
+       << " integrals/s" << endl;
+  cout << "  largest difference " << diff << ", first table for n = 2000 "
+       << t4 - t6 << " s" << endl;
+}
+// Points per second and error of the midpoint rule for Runge's function
+// on [-1, 1] with 10^7 intervals: rectangle_rule() through a function
+// pointer, the templated rule with the integrand inlined, with an array
+// callback and with threads. Then the evaluations Romberg needs for an
+// error of 1e-10.
+void bench_rules()
+{
+  size_t n = 10000000;
+  double exact = 0.4*atan(5.0);
+  cout << "midpoint rule, " << n << " intervals" << endl;
+
+  auto f = [](double x) { return 1.0/(1.0 + 25.0*x*x); };
+  double t0 = now();
+  double r = rectangle_rule(-1.0, 1.0, n, runge);
+  double t1 = now();
+  cout << setw(30) << left << "  rectangle_rule()" << n/(t1 - t0)
+       << " points/s, error " << r - exact << endl;
+
+  t0 = now();
+  r = midpoint(-1.0, 1.0, n, f);
+  t1 = now();
+  cout << setw(30) << "  midpoint()" << n/(t1 - t0) << " points/s, error "
+       << r - exact << endl;
+
+  t0 = now();
+  r = midpoint_batch(-1.0, 1.0, n, runge_batch);
+  t1 = now();
+  cout << setw(30) << "  midpoint_batch()" << n/(t1 - t0)
+       << " points/s, error " << r - exact << endl;
+
+  for (int nthreads=2; nthreads<=8; nthreads*=2) {
+    t0 = now();
+    r = midpoint(-1.0, 1.0, n, f, nthreads);
+    t1 = now();
+    cout << "  midpoint(), " << setw(16) << to_string(nthreads) + " threads"
+         << n/(t1 - t0) << " points/s, error " << r - exact << endl;
+  }
+
+  long nfev;
+  int status = romberg(-1.0, 1.0, f, r, nfev, 1e-10);
+  cout << "  romberg(), status " << status << ": " << nfev
+       << " evaluations, error " << r - exact << endl;
+}
+
+// Points per second when resampling a spline through n knots on [0, 100]
+// at m sorted points: splint() for every point, and a Spline one point at
+// a time and with evaluate(), on equally and on unequally spaced knots.
+void bench_spline()
+{
+  size_t n = 2001, m = 10000000;
+  cout << "cubic spline, " << n << " knots, " << m << " sorted points" << endl;
+  vector<double> xq(m), yq(m), ref(m);
+  for (size_t k=0; k<m; k++) xq[k] = 100.0*k/(m - 1);
+
+  for (int uniform=1; uniform>=0; uniform--) {
+    vector<double> x(n), y(n), y2(n);
+    for (size_t i=0; i<n; i++) {
+      double s = (double) i/(n - 1);
+      x[i] = uniform ? 100.0*s : 100.0*s*s;
+      y[i] = sin(0.3*x[i]) + 0.01*x[i];
+    }
+    cout << (uniform ? "  equal spacing" : "  unequal spacing") << endl;
+
+    double t0 = now();
+    spline(&x[0], &y[0], n, 1e31, 1e31, &y2[0]);
+    for (size_t k=0; k<m; k++) splint(&x[0], &y[0], &y2[0], n, xq[k], &ref[k]);
+    double t1 = now();
+    cout << setw(30) << left << "    splint()" << m/(t1 - t0) << " points/s"
+         << endl;
+
+    t0 = now();
+    Spline s(&x[0], &y[0], n);
+    for (size_t k=0; k<m; k++) yq[k] = s(xq[k]);
+    t1 = now();
+    double diff = 0.0;
+    for (size_t k=0; k<m; k++) diff = max(diff, fabs(yq[k] - ref[k]));
+    cout << setw(30) << "    Spline::operator()" << m/(t1 - t0)
+         << " points/s, largest difference " << diff << endl;
+
+    t0 = now();
+    s.evaluate(&xq[0], &yq[0], m);
+    t1 = now();
+    diff = 0.0;
+    for (size_t k=0; k<m; k++) diff = max(diff, fabs(yq[k] - ref[k]));
+    cout << setw(30) << "    Spline::evaluate()" << m/(t1 - t0)
+         << " points/s, largest difference " << diff << endl;
+  }
+}
+
+// Points per second for polynomial interpolation through n nodes on
+// [0, 1] with polint() and with Barycentric one point at a time and with
+// evaluate(), with and without the error estimate
+void bench_barycentric()
+{
+  size_t m = 1000000;
+  vector<double> xq(m), yq(m), dq(m), ref(m);
+  for (size_t k=0; k<m; k++) xq[k] = (k + 0.5)/m;
+  for (size_t n=8; n<=32; n*=2) {
+    cout << "polynomial interpolation, " << n << " nodes, " << m << " points"
+         << endl;
+    vector<double> x(n), y(n);
+    Barycentric::chebyshev_points(0.0, 1.0, n, &x[0]);
+    for (size_t i=0; i<n; i++) y[i] = exp(-x[i])*cos(3.0*x[i]);
+
+    double t0 = now();
+    for (size_t k=0; k<m; k++) polint(&x[0], &y[0], n, xq[k], &ref[k], &dq[k]);
+    double t1 = now();
+    cout << setw(30) << left << "  polint()" << m/(t1 - t0) << " points/s"
+         << endl;
+
+    t0 = now();
+    Barycentric p(&x[0], &y[0], n);
+    for (size_t k=0; k<m; k++) yq[k] = p(xq[k]);
+    t1 = now();
+    double diff = 0.0;
+    for (size_t k=0; k<m; k++) diff = max(diff, fabs(yq[k] - ref[k]));
+    cout << setw(30) << "  Barycentric::operator()" << m/(t1 - t0)
+         << " points/s, largest difference " << diff << endl;
+
+    t0 = now();
+    p.evaluate(&xq[0], &yq[0], m);
+    t1 = now();
+    diff = 0.0;
+    for (size_t k=0; k<m; k++) diff = max(diff, fabs(yq[k] - ref[k]));
+    cout << setw(30) << "  Barycentric::evaluate()" << m/(t1 - t0)
+         << " points/s, largest difference " << diff << endl;
+
+    t0 = now();
+    p.evaluate(&xq[0], &yq[0], m, &dq[0]);
+    t1 = now();
+    double err = 0.0, est = 0.0;
+    for (size_t k=0; k<m; k++) {
+      err = max(err, fabs(yq[k] - exp(-xq[k])*cos(3.0*xq[k])));
+      est = max(est, fabs(dq[k]));
+    }
+    cout << setw(30) << "    with error estimate" << m/(t1 - t0)
+         << " points/s, error " << err << ", estimate " << est << endl;
+  }
+}
+
+// Final size z of an epidemic with reproduction number R0, the root of
+// z - 1 + exp(-R0 z) in (0, 1) for R0 > 1, for the scalar root finders
+static double final_size_R0;
+
+double final_size(double z)
+{
+  return z - 1.0 + exp(-final_size_R0*z);
+}
+
+// The same for a whole sweep of R0 values, one per lane
+struct FinalSize
+{
+  const double* R0;
+
+  void operator()(const double* z, double* y, size_t first, size_t n) const {
+    for (size_t i=0; i<n; i++) y[i] = z[i] - 1.0 + exp(-R0[first + i]*z[i]);
+  }
+};
+
+// Equations per second when solving the final-size equation for m values
+// of R0 with rtbis() and zbrent() one at a time and with the batched
+// versions, with the mean number of iterations per equation. zbrent()
+// stops at a relative accuracy of 3e-8, zbrent_batch() at the machine
+// precision, so they differ by about that much.
+void bench_roots()
+{
+  size_t m = 100000;
+  double xacc = 1e-10;
+  vector<double> R0(m), x1(m), x2(m), root(m), ref(m);
+  vector<int> status(m), iter(m);
+  for (size_t k=0; k<m; k++) {
+    R0[k] = 1.2 + 3.8*k/m;
+    x1[k] = (R0[k] - 1.0)/(R0[k]*R0[k]);     // f < 0 here
+    x2[k] = 1.0;
+  }
+  FinalSize f = {&R0[0]};
+  cout << "final size for " << m << " values of R0" << endl;
+
+  for (int brent=0; brent<=1; brent++) {
+    double t0 = now();
+    for (size_t k=0; k<m; k++) {
+      final_size_R0 = R0[k];
+      ref[k] = brent ? zbrent(final_size, x1[k], x2[k], xacc)
+                     : rtbis(final_size, x1[k], x2[k], xacc);
+    }
+    double t1 = now();
+    cout << setw(30) << left << (brent ? "  zbrent()" : "  rtbis()")
+         << m/(t1 - t0) << " equations/s" << endl;
+
+    t0 = now();
+    size_t failed = brent
+      ? zbrent_batch(f, &x1[0], &x2[0], m, xacc, &root[0], &status[0], &iter[0])
+      : rtbis_batch(f, &x1[0], &x2[0], m, xacc, &root[0], &status[0], &iter[0]);
+    t1 = now();
+    double diff = 0.0, iters = 0.0;
+    for (size_t k=0; k<m; k++) {
+      diff = max(diff, fabs(root[k] - ref[k]));
+      iters += iter[k];
+    }
+    cout << setw(30) << (brent ? "  zbrent_batch()" : "  rtbis_batch()")
+         << m/(t1 - t0) << " equations/s, " << iters/m << " iterations, "
+         << failed << " failed, largest difference " << diff << endl;
+  }
+}
+
+int main()
+{
+  bench_rk4_batch();
+  bench_trajectory_store();
+  bench_lu();
+  bench_jacobi();
+  bench_eigen();
+  bench_quadrature();
+  bench_rules();
+  bench_spline();
+  bench_barycentric();
+  bench_roots();
+  return 0;
+}
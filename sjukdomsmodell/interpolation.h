@@ -0,0 +1,329 @@
+    /*
+     * The definition module
+     *                      interpolation.h
+     * for cubic spline interpolation of a tabulated function. Unlike
+     * spline() and splint() in lib.cpp, a Spline keeps its knots and the
+     * cubic of every interval, so that nothing is allocated or solved when
+     * evaluating. The interval of a point is found in O(1) when the knots
+     * are equally spaced and by bisection otherwise, and a sorted array of
+     * points is evaluated by walking a cursor forwards through the knots.
+     *
+     * Also polynomial interpolation in barycentric form, replacing
+     * repeated calls of polint(): the weights of the nodes are computed
+     * once, after which each point costs O(n) instead of O(n^2), and new
+     * values on the same nodes cost nothing extra. Chebyshev points, where
+     * the interpolation is well conditioned for any n, have closed-form
+     * weights.
+     */
+
+#ifndef INTERPOLATION_H
+#define INTERPOLATION_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+#include "lib.h"
+
+class Spline
+{
+public:
+  // Points per block in evaluate()
+  static const size_t block = 256;
+
+  Spline() : n_(0), uniform_(false), x0_(0.0), inv_h_(0.0) {
+  }
+
+  /*
+  The cubic spline through (x[i], y[i]), i = 0,..,n-1, with n >= 2 and the
+  x[i] increasing. yp1 and ypn are the first derivatives at the ends; a
+  value above 0.99e30, as the default HUGE_VAL, gives a natural end with
+  zero second derivative, as in spline().
+  */
+  Spline(const double* x, const double* y, size_t n,
+         double yp1 = HUGE_VAL, double ypn = HUGE_VAL)
+    : n_(0), uniform_(false), x0_(0.0), inv_h_(0.0) {
+    set(x, y, n, yp1, ypn);
+  }
+
+  // New table; the memory is reused when n does not grow
+  void set(const double* x, const double* y, size_t n,
+           double yp1 = HUGE_VAL, double ypn = HUGE_VAL) {
+    n_ = n;
+    x_.assign(x, x + n);
+    y2_.resize(n);
+    work_.resize(n);
+    spline(&x_[0], (double*) y, (int) n, yp1, ypn, &y2_[0], &work_[0]);
+
+    // y = c0 + t*(c1 + t*(c2 + t*c3)) with t = x - x[i] on interval i
+    c_.resize(4*(n - 1));
+    for (size_t i=0; i+1<n; i++) {
+      double h = x[i+1] - x[i];
+      double* c = &c_[4*i];
+      c[0] = y[i];
+      c[1] = (y[i+1] - y[i])/h - h*(2.0*y2_[i] + y2_[i+1])/6.0;
+      c[2] = 0.5*y2_[i];
+      c[3] = (y2_[i+1] - y2_[i])/(6.0*h);
+    }
+
+    // Equally spaced knots, to rounding, are indexed directly
+    x0_ = x[0];
+    double h = (x[n-1] - x[0])/(n - 1);
+    inv_h_ = 1.0/h;
+    uniform_ = true;
+    for (size_t i=1; i<n && uniform_; i++) {
+      uniform_ = fabs(x[i] - (x0_ + i*h)) <= 1e-10*h;
+    }
+  }
+
+  size_t size() const { return n_; }
+  bool uniform() const { return uniform_; }
+
+  // Second derivatives at the knots, as spline() returns them in y2[]
+  const double* y2() const { return &y2_[0]; }
+
+  // Interval i with x[i] <= x < x[i+1], the end intervals outside [x[0], x[n-1]]
+  size_t interval(double x) const {
+    if (uniform_) {
+      double u = (x - x0_)*inv_h_;
+      if (!(u >= 1.0)) return 0;              // also for NaN
+      if (u >= (double) (n_ - 2)) return n_ - 2;
+      return (size_t) u;
+    }
+    size_t i = std::upper_bound(x_.begin() + 1, x_.end() - 1, x) - x_.begin();
+    return i - 1;
+  }
+
+  double operator()(double x) const {
+    return value(interval(x), x);
+  }
+
+  /*
+  Setting yq[k] to the spline at xq[k] for k < m. For increasing xq the
+  interval is found by stepping forwards from that of the previous point,
+  so a sorted array costs O(m + n) lookups in all; other orders are
+  handled correctly by bisection. The polynomials are evaluated in a
+  separate loop over each block, which the compiler can vectorize.
+  */
+  void evaluate(const double* xq, double* yq, size_t m) const {
+    size_t idx[block];
+    size_t i = 0;
+    for (size_t k0=0; k0<m; k0+=block) {
+      size_t nk = m - k0 < block ? m - k0 : block;
+      const double* xb = xq + k0;
+      if (uniform_) {
+        for (size_t k=0; k<nk; k++) idx[k] = interval(xb[k]);
+      }
+      else {
+        for (size_t k=0; k<nk; k++) {
+          i = walk(i, xb[k]);
+          idx[k] = i;
+        }
+      }
+      double* yb = yq + k0;
+      for (size_t k=0; k<nk; k++) yb[k] = value(idx[k], xb[k]);
+    }
+  }
+
+private:
+  size_t n_;
+  bool uniform_;
+  double x0_, inv_h_;
+  std::vector<double> x_, y2_, work_;
+  std::vector<double> c_;         // c0..c3 of each interval in turn
+
+  double value(size_t i, double x) const {
+    const double* c = &c_[4*i];
+    double t = x - x_[i];
+    return c[0] + t*(c[1] + t*(c[2] + t*c[3]));
+  }
+
+  // Interval of x starting the search at interval i
+  size_t walk(size_t i, double x) const {
+    if (x < x_[i]) return interval(x);
+    for (int step=0; step<8; step++) {
+      if (i + 2 >= n_ || x < x_[i+1]) return i;
+      i++;
+    }
+    size_t j = std::upper_bound(x_.begin() + i + 1, x_.end() - 1, x)
+      - x_.begin();
+    return j - 1;
+  }
+};
+
+class Barycentric
+{
+public:
+  // Points per block in evaluate()
+  static const size_t block = 256;
+
+  Barycentric() {
+  }
+
+  // The polynomial of degree n-1 through (x[i], y[i]), the x[i] distinct
+  Barycentric(const double* x, const double* y, size_t n)
+    : x_(x, x + n), y_(y, y + n), w_(n) {
+    // The differences are scaled by 4/(length of the interval), which
+    // keeps the products of many of them from overflowing or underflowing
+    double lo = *std::min_element(x, x + n), hi = *std::max_element(x, x + n);
+    double scale = hi > lo ? 4.0/(hi - lo) : 1.0;
+    for (size_t j=0; j<n; j++) {
+      double p = 1.0;
+      for (size_t k=0; k<n; k++) {
+        if (k != j) p *= scale*(x[j] - x[k]);
+      }
+      w_[j] = 1.0/p;
+    }
+  }
+
+  /*
+  Interpolation of f at the n Chebyshev points of the second kind on
+  [a, b] in increasing order, see chebyshev_points(), with the weights
+  (-1)^j, halved at the ends.
+  */
+  template<class F>
+  static Barycentric chebyshev(F f, double a, double b, size_t n) {
+    Barycentric p;
+    p.x_.resize(n);
+    p.y_.resize(n);
+    p.w_.resize(n);
+    chebyshev_points(a, b, n, &p.x_[0]);
+    for (size_t j=0; j<n; j++) {
+      p.y_[j] = f(p.x_[j]);
+      p.w_[j] = (j % 2 ? -1.0 : 1.0)*(j == 0 || j == n - 1 ? 0.5 : 1.0);
+    }
+    return p;
+  }
+
+  // The extrema of the Chebyshev polynomial T_(n-1) mapped to [a, b],
+  // including both ends, in increasing order
+  static void chebyshev_points(double a, double b, size_t n, double* x) {
+    if (n == 1) {
+      x[0] = 0.5*(a + b);
+      return;
+    }
+    for (size_t j=0; j<n; j++) {
+      double c = -cos(M_PI*j/(n - 1));
+      x[j] = 0.5*(a + b) + 0.5*(b - a)*c;
+    }
+  }
+
+  size_t size() const { return x_.size(); }
+  const double* x() const { return &x_[0]; }
+  const double* w() const { return &w_[0]; }
+
+  // New values y[0..n-1] at the same nodes; the weights are kept
+  void set_values(const double* y) {
+    y_.assign(y, y + y_.size());
+  }
+
+  double operator()(double x) const {
+    double num = 0.0, den = 0.0;
+    for (size_t j=0; j<x_.size(); j++) {
+      double t = w_[j]/(x - x_[j]);
+      num += t*y_[j];
+      den += t;
+    }
+    double p = num/den;
+    return std::isfinite(p) ? p : at_node(x, p);
+  }
+
+  /*
+  The value at x, and in dy the difference from the polynomial through
+  all nodes but the last, as an estimate of the error like the dy of
+  polint(). The second polynomial has the weights w[j](x[j] - x[n-1])
+  and comes from the same pass over the nodes.
+  */
+  double operator()(double x, double& dy) const {
+    size_t n = x_.size();
+    double num = 0.0, den = 0.0, num1 = 0.0, den1 = 0.0;
+    for (size_t j=0; j<n; j++) {
+      double t = w_[j]/(x - x_[j]);
+      double t1 = t*(x_[j] - x_[n-1]);
+      num += t*y_[j];
+      den += t;
+      num1 += t1*y_[j];
+      den1 += t1;
+    }
+    double p = num/den, p1 = num1/den1;
+    if (!std::isfinite(p) || !std::isfinite(p1)) {
+      // x is a node: fall back to the first form of the second polynomial
+      p = at_node(x, p);
+      if (n < 2) p1 = p;
+      else if (x == x_[n-1]) p1 = reduced(x);
+      else p1 = at_node(x, p1);
+    }
+    dy = p - p1;
+    return p;
+  }
+
+  /*
+  Setting yq[k] to the polynomial at xq[k] for k < m, and dy[k] to the
+  error estimate above unless dy is null. The sums run over a block of
+  points in the inner loop and over the nodes in the outer one, so that
+  they vectorize without reordering any sum.
+  */
+  void evaluate(const double* xq, double* yq, size_t m, double* dy = 0) const {
+    size_t n = x_.size();
+    double num[block], den[block], num1[block], den1[block];
+    for (size_t k0=0; k0<m; k0+=block) {
+      size_t nk = m - k0 < block ? m - k0 : block;
+      const double* xb = xq + k0;
+      for (size_t k=0; k<nk; k++) num[k] = den[k] = num1[k] = den1[k] = 0.0;
+      for (size_t j=0; j<n; j++) {
+        double xj = x_[j], wj = w_[j], yj = y_[j];
+        if (dy) {
+          double dj = xj - x_[n-1];
+          for (size_t k=0; k<nk; k++) {
+            double t = wj/(xb[k] - xj);
+            num[k] += t*yj;
+            den[k] += t;
+            num1[k] += t*dj*yj;
+            den1[k] += t*dj;
+          }
+        }
+        else {
+          for (size_t k=0; k<nk; k++) {
+            double t = wj/(xb[k] - xj);
+            num[k] += t*yj;
+            den[k] += t;
+          }
+        }
+      }
+      for (size_t k=0; k<nk; k++) {
+        double p = num[k]/den[k];
+        if (dy) {
+          double p1 = num1[k]/den1[k];
+          if (std::isfinite(p) && std::isfinite(p1)) dy[k0+k] = p - p1;
+          else p = (*this)(xb[k], dy[k0+k]);
+        }
+        yq[k0+k] = std::isfinite(p) ? p : at_node(xb[k], p);
+      }
+    }
+  }
+
+private:
+  std::vector<double> x_, y_, w_;
+
+  // y[j] if x is the node x[j], otherwise p
+  double at_node(double x, double p) const {
+    for (size_t j=0; j<x_.size(); j++) {
+      if (x == x_[j]) return y_[j];
+    }
+    return p;
+  }
+
+  // The polynomial through all nodes but the last at that node
+  double reduced(double x) const {
+    size_t n = x_.size();
+    double num = 0.0, den = 0.0;
+    for (size_t j=0; j+1<n; j++) {
+      double t = w_[j]*(x_[j] - x_[n-1])/(x - x_[j]);
+      num += t*y_[j];
+      den += t;
+    }
+    return num/den;
+  }
+};
+
+#endif
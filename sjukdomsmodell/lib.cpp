@@ -51,7 +51,13 @@ void lubksb(double **a, int n, int *indx, double *b)
     ** The function is slightly modified from the version in 
     ** in Numerical recipe.
 
-void tqli(double d[], double e[], int n, double **z)
+void ludcmp(double *a, int n, int *indx, double *d)
+void lubksb(double *a, int n, int *indx, double *b, int nrhs)
+    ** blocked versions of the two functions above for a matrix stored
+    ** contiguously row by row, where lubksb() solves for nrhs right-hand
+    ** sides stored as the columns of the n x nrhs row-major matrix b[].
+
+int tqli(double d[], double e[], int n, double **z)
     ** determine eigenvalues and eigenvectors of a real symmetric
     ** tri-diagonal matrix, or a real, symmetric matrix previously
     ** reduced by function tred2[] to tri-diagonal form. On input,
@@ -73,6 +79,12 @@ void tred2(double **a, int n, double d[], double e[])
     ** with e[0] = 0.
     ** The function is modified from the version in Numerical recipe.
 
+void tred2(double *a, int n, double d[], double e[], int vectors)
+int tqli(double d[], double e[], int n, double *z)
+    ** blocked and contiguous versions of the two functions above, where
+    ** tred2() only forms the orthogonal matrix if vectors is nonzero and
+    ** tqli() only finds the eigenvalues if z is (double *) 0.
+
 double pythag(double a, double b)
     ** The function is modified from the version in Numerical recipe.
 
@@ -81,14 +93,26 @@ void gauleg(double x1, double x2, double x[], double w[], int n)
     ** and return the abcissas in x[0,...,n - 1] and the weights in w[0,...,n - 1]
     ** of length n of the Gauss--Legendre n--point quadrature formulae.
 
-void jacobi(double** a, double* d, double** v, int n, int& nrot)
+const double* gauleg_table(int n)
+    ** returns the abcissas and weights of the n-point Gauss--Legendre rule
+    ** on [-1, 1], computed once per n and cached in a thread-safe registry.
+    ** See also quadrature.h.
+
+int jacobi(double** a, double* d, double** v, int n, int& nrot)
     ** Computes the eigenvalues and eigenvectors of the square symmetric matrix
     ** a  by use of the Jacobi method.
     ** It puts the eigenvalues in d and eigenvectors in v.
     ** n is an integer denoting the size of a
     **nrot keeps track of the number of rotations
+    ** Returns 0 on convergence and 1 if it does not converge in 50 sweeps.
     ** The function is as in the Numerical recipe
 
+int jacobi(double *a, double *d, double *v, int n, int& nrot, int nthreads,
+           int maxsweeps)
+    ** as above for a matrix stored contiguously row by row, with the
+    ** rotations of each sweep done in round-robin order by nthreads
+    ** threads.
+
 void jacobi_rot(double** a, double s, double tau, int i, int j, int k, int l)
 	 ** A helping function for jacobi making the actual rotations
 	 ** a is the matrix to be rotated, s is sine of the rotation
@@ -108,8 +132,12 @@ void spline(double x[], double y[], int n, double yp1, double yp2, double y2[])
     ** y_i = f(x_i) with x_0 < x_1 < .. < x_(n - 1) together with yp_1 and yp2
     ** for first derivatives  f(x) at x_0 and x_(n-1), respectively. Then the
     ** function returns y2[0,..,n-1] which contanin the second derivatives of
-    ** f(x_i)at each point x_i. If yp1 and/or yp2 is larger than the constant
-    ** INFINITY the function will put corresponding second derivatives to zero.
+    ** f(x_i)at each point x_i. If yp1 and/or yp2 is larger than 0.99e30, e.g.
+    ** INFINITY, the function will put corresponding second derivatives to zero.
+
+void spline(double x[], double y[], int n, double yp1, double yp2, double y2[],
+            double *u)
+    ** as above, with a caller-owned scratch array u[0,..,n - 1]
 
 void splint(double xa[], double ya[], double y2a[], int n, double x, double *y)
     ** takes xa[0,..,n - 1] and y[0,..,n - 1] which tabulates a function 
@@ -159,6 +187,12 @@ double ran3(long *idum)
     */
 
 #include "lib.h"
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 
   /*
@@ -172,11 +206,13 @@ double ran3(long *idum)
    *  int num_bytes- number of bytes for each 
    *                 element                  
    * Returns a void  **pointer to the reserved memory location.                                
+   * For typed, aligned matrices that free themselves, see matrix.h.
    */
 
 void **matrix(int row, int col, int num_bytes)
   {
-  int      i, num;
+  int      i;
+  size_t   num, bytes;
   char     **pointer, *ptr;
 
   pointer = new(nothrow) char* [row];
@@ -185,15 +221,16 @@ void **matrix(int row, int col, int num_bytes)
     cout << " for "<< row << "row addresses !" << endl;
     return NULL;
   }
-  i = (row * col * num_bytes)/sizeof(char);
-  pointer[0] = new(nothrow) char [i];
+  bytes = (size_t) row * col * num_bytes;   // in 64 bits, may exceed int
+  pointer[0] = new(nothrow) char [bytes];
   if(!pointer[0]) {
     cout << "Exception handling: Memory allocation failed";
-    cout << " for address to " << i << " characters !" << endl;
+    cout << " for address to " << bytes << " characters !" << endl;
+    delete [] pointer;
     return NULL;
   }
   ptr = pointer[0];
-  num = col * num_bytes;
+  num = (size_t) col * num_bytes;
   for(i = 0; i < row; i++, ptr += num )   {
     pointer[i] = ptr; 
   }
@@ -227,36 +264,20 @@ void free_matrix(void **matr)
       ** advance the solution over an interval h and return incremented variables
       ** as yout[1:n], which not need to be a disstinct arra from y[1:n]. The
       ** users supply the routine derivs(x,y,dydx), which returns the derivatives
-      ** dydx at x.
+      ** dydx at x. The scratch array work[] of length 3n is owned by the
+      ** caller, so no memory is allocated here. When n is known at compile
+      ** time, prefer the templated rk4<n>() in rk4.h.
       */ 
 
 void rk4(double *y, double *dydx, int n, double x, double h, double  *yout,
-	                void (*derivs)(double, double *, double *))
+	                void (*derivs)(double, double *, double *), double *work)
 {
   int      i;
   double   xh,hh,h6,*dym,*dyt,*yt;
 
-
-              // local memory allocation
-
-  dym = new(nothrow) double [n];
-  if(!dym) {
-    printf("\n\nError in function rk4():");
-    printf("\nNot enough memory for dym[%d]\n",n);
-    exit(1);
-  }
-  dyt = new(nothrow) double [n];
-  if(!dyt) {
-    printf("\n\nError in function rk4():");
-    printf("\nNot enough memory for dyt[%d]\n",n);
-    exit(1);
-  }
-  yt = new(nothrow) double [n];
-  if(!yt) {
-    printf("\n\nError in function rk4():");
-    printf("\nNot enough memory for yt[%d]\n",n);
-    exit(1);
-  }
+  dym = work;
+  dyt = work + n;
+  yt  = work + 2*n;
 
    hh = h * 0.5;
    h6 = h/6.0;
@@ -268,13 +289,13 @@ void rk4(double *y, double *dydx, int n, double x, double h, double  *yout,
 
    (*derivs)(xh, yt, dyt);                 // second step
 
-   for(i = 1; i < n; i++) {
+   for(i = 0; i < n; i++) {
       yt[i] = y[i] + hh * dyt[i];
    }
 
    (*derivs)(xh, yt, dym);                // third step 
 
-   for(i = 1; i < n; i++) {
+   for(i = 0; i < n; i++) {
       yt[i]   = y[i] + h * dym[i];
       dym[i] += dyt[i];
    }
@@ -286,10 +307,32 @@ void rk4(double *y, double *dydx, int n, double x, double h, double  *yout,
    for(i = 0; i< n; i++) {
       yout[i] = y[i] + h6 *(dydx[i] + dyt[i] + 2.0 * dym[i]);
    }
-   
-   delete [] yt;     // release local memory
-   delete [] dyt;
-   delete [] dym;
+
+} // End: function rk4()
+
+      /*
+      ** The function
+      **              rk4()
+      ** as above, but reserves the scratch memory itself on every call.
+      */ 
+
+void rk4(double *y, double *dydx, int n, double x, double h, double  *yout,
+	                void (*derivs)(double, double *, double *))
+{
+  double   *work;
+
+              // local memory allocation
+
+  work = new(nothrow) double [3*n];
+  if(!work) {
+    printf("\n\nError in function rk4():");
+    printf("\nNot enough memory for work[%d]\n",3*n);
+    exit(1);
+  }
+
+  rk4(y, dydx, n, x, h, yout, derivs, work);
+
+  delete [] work;     // release local memory
 
 } // End: function rk4()
 
@@ -416,6 +459,235 @@ void lubksb(double **a, int n, int *indx, double *b)
    }
 } // End: function lubksb()
 
+    /*
+    ** The function
+    **             lu_update()
+    ** is the inner kernel of the blocked LU routines below. It computes
+    ** C = C - A B, where A is m x k, B is k x n and C is m x n, all stored
+    ** row-major with leading dimensions lda, ldb and ldc, and C must not
+    ** overlap A or B. C is updated in tiles of 4 rows and LU_NR columns
+    ** held in local accumulators, which the compiler keeps in vector
+    ** registers. B is copied in column blocks of LU_NC to a contiguous
+    ** buffer, which stays in cache and avoids the cache conflicts of
+    ** rows a power of two apart.
+    */
+
+static const int LU_NB = 64;        // panel width of the blocked LU
+static const int LU_NC = 256;       // columns of B per cache block
+static const int LU_NR = 16;        // columns of C per register tile
+
+static void lu_update(int m, int n, int k, const double *__restrict a,
+                      long lda, const double *__restrict b, long ldb,
+                      double *__restrict c, long ldc)
+{
+   int      i, j, j0, jn, p, q;
+   double   t0[LU_NR], t1[LU_NR], t2[LU_NR], t3[LU_NR];
+   double   x0, x1, x2, x3, bq, *bb;
+
+  bb = new(nothrow) double [k*LU_NC];
+  if(!bb) {
+    printf("\n\nError in function lu_update():");
+    printf("\nNot enough memory for bb[%d]\n",k*LU_NC);
+    exit(1);
+  }
+
+   for(j0 = 0; j0 < n; j0 += LU_NC) {
+      jn = min(j0 + LU_NC, n);
+      for(p = 0; p < k; p++) {      // copy the block of B to contiguous rows
+         for(q = j0; q < jn; q++) bb[p*LU_NC + q - j0] = b[p*ldb + q];
+      }
+      for(i = 0; i + 4 <= m; i += 4) {
+         const double *a0 = a + i*lda, *a1 = a0 + lda;
+         const double *a2 = a1 + lda, *a3 = a2 + lda;
+         double *c0 = c + i*ldc, *c1 = c0 + ldc;
+         double *c2 = c1 + ldc, *c3 = c2 + ldc;
+         for(j = j0; j + LU_NR <= jn; j += LU_NR) {
+            for(q = 0; q < LU_NR; q++) {
+               t0[q] = c0[j+q]; t1[q] = c1[j+q];
+               t2[q] = c2[j+q]; t3[q] = c3[j+q];
+            }
+            for(p = 0; p < k; p++) {
+               const double *bp = bb + p*LU_NC + j - j0;
+               x0 = a0[p]; x1 = a1[p]; x2 = a2[p]; x3 = a3[p];
+               for(q = 0; q < LU_NR; q++) {
+                  bq = bp[q];
+                  t0[q] -= x0*bq; t1[q] -= x1*bq;
+                  t2[q] -= x2*bq; t3[q] -= x3*bq;
+               }
+            }
+            for(q = 0; q < LU_NR; q++) {
+               c0[j+q] = t0[q]; c1[j+q] = t1[q];
+               c2[j+q] = t2[q]; c3[j+q] = t3[q];
+            }
+         }
+         for(p = 0; p < k; p++) {             // columns right of the tiles
+            x0 = a0[p]; x1 = a1[p]; x2 = a2[p]; x3 = a3[p];
+            for(q = j; q < jn; q++) {
+               bq = bb[p*LU_NC + q - j0];
+               c0[q] -= x0*bq; c1[q] -= x1*bq;
+               c2[q] -= x2*bq; c3[q] -= x3*bq;
+            }
+         }
+      }
+      for(; i < m; i++) {                     // rows below the tiles
+         for(p = 0; p < k; p++) {
+            x0 = a[i*lda + p];
+            for(q = j0; q < jn; q++) c[i*ldc + q] -= x0*bb[p*LU_NC + q - j0];
+         }
+      }
+   }
+
+   delete [] bb;   // release local memory
+
+} // End: function lu_update()
+
+    /*
+    ** The function
+    **       ludcmp()
+    ** as ludcmp() above, with the same implicit pivoting, the same indx[]
+    ** and d, and the same treatment of zero pivots, but for a matrix
+    ** stored contiguously row by row in a[0,..,n*n - 1], e.g. a[0] of a
+    ** matrix from matrix(). The decomposition is right-looking and
+    ** blocked: a panel of LU_NB columns is factored, the rows of U to the
+    ** right of it are found by forward substitution, and the trailing
+    ** matrix is updated by lu_update(), where nearly all the work is done.
+    */
+
+void ludcmp(double *a, int n, int *indx, double *d)
+{
+   int      i, imax, j, k, k0, kn;
+   long     ln = n;
+   double   big, dum, temp, *vv;
+
+  vv = new(nothrow) double [n];
+  if(!vv) {
+    printf("\n\nError in function ludcmp():");
+    printf("\nNot enough memory for vv[%d]\n",n);
+    exit(1);
+  }
+
+   *d = 1.0;                              // no row interchange yet
+   for(i = 0; i < n; i++) {     // loop over rows to get scaling information
+      big = ZERO;
+      for(j = 0; j < n; j++) {
+         if((temp = fabs(a[i*ln + j])) > big) big = temp;
+      }
+      if(big == ZERO) {
+         printf("\n\nSingular matrix in routine ludcmp()\n");
+         exit(1);
+      }
+      vv[i] = 1.0/big;                 // save scaling
+   } // end i-loop
+
+   for(k0 = 0; k0 < n; k0 += LU_NB) {    // loop over panels
+      kn = min(k0 + LU_NB, n);
+      for(j = k0; j < kn; j++) {          // factor the panel column by column
+         big = ZERO;
+         imax = j;
+         for(i = j; i < n; i++) {
+            if((dum = vv[i]*fabs(a[i*ln + j])) >= big) {
+               big = dum;
+               imax = i;
+            }
+         }
+         if(j != imax) {                  // interchange whole rows
+            for(k = 0; k < n; k++) {
+               dum             = a[imax*ln + k];
+               a[imax*ln + k]  = a[j*ln + k];
+               a[j*ln + k]     = dum;
+            }
+            (*d)    *= -1;
+            vv[imax] = vv[j];
+         }
+         indx[j] = imax;
+         if(fabs(a[j*ln + j]) < ZERO) a[j*ln + j] = ZERO;
+
+         dum = 1.0/a[j*ln + j];
+         for(i = j + 1; i < n; i++) {     // column of L, update rest of panel
+            double l = (a[i*ln + j] *= dum);
+            for(k = j + 1; k < kn; k++) a[i*ln + k] -= l*a[j*ln + k];
+         }
+      }
+      if(kn == n) break;
+
+                  // rows of U right of the panel: U12 = L11^(-1) A12
+
+      for(i = k0 + 1; i < kn; i++) {
+         for(k = k0; k < i; k++) {
+            double l = a[i*ln + k];
+            for(j = kn; j < n; j++) a[i*ln + j] -= l*a[k*ln + j];
+         }
+      }
+
+                  // trailing matrix: A22 = A22 - L21 U12
+
+      lu_update(n - kn, n - kn, kn - k0, a + kn*ln + k0, ln,
+                a + k0*ln + kn, ln, a + kn*ln + kn, ln);
+   } // end loop over panels
+
+   delete [] vv;   // release local memory
+
+}  // End: function ludcmp()
+
+    /*
+    ** The function
+    **             lubksb()
+    ** solves A X = B for nrhs right-hand sides at once, with a[] and indx[]
+    ** from the contiguous ludcmp() above. b[] holds B as an n x nrhs
+    ** matrix stored row by row, i.e. right-hand side r is the column
+    ** b[r], b[nrhs + r], ..., and is overwritten by X. The forward and
+    ** backward substitutions are blocked like the decomposition, so that
+    ** most of the work is done by lu_update() over all right-hand sides.
+    ** With nrhs = 1 it solves a single system, as the lubksb() above.
+    */
+
+void lubksb(double *a, int n, int *indx, double *b, int nrhs)
+{
+   int      i, j, k, k0, kn;
+   long     ln = n, lr = nrhs;
+   double   dum;
+
+   for(i = 0; i < n; i++) {               // apply the row interchanges
+      if(indx[i] != i) {
+         for(j = 0; j < nrhs; j++) {
+            dum                = b[indx[i]*lr + j];
+            b[indx[i]*lr + j]  = b[i*lr + j];
+            b[i*lr + j]        = dum;
+         }
+      }
+   }
+
+   for(k0 = 0; k0 < n; k0 += LU_NB) {    // forward substitution, L Y = B
+      kn = min(k0 + LU_NB, n);
+      for(i = k0 + 1; i < kn; i++) {
+         for(k = k0; k < i; k++) {
+            double l = a[i*ln + k];
+            for(j = 0; j < nrhs; j++) b[i*lr + j] -= l*b[k*lr + j];
+         }
+      }
+      if(kn < n) {
+         lu_update(n - kn, nrhs, kn - k0, a + kn*ln + k0, ln,
+                   b + k0*lr, lr, b + kn*lr, lr);
+      }
+   }
+
+   for(kn = n; kn > 0; kn -= LU_NB) {    // backward substitution, U X = Y
+      k0 = max(kn - LU_NB, 0);
+      for(i = kn - 1; i >= k0; i--) {
+         for(k = i + 1; k < kn; k++) {
+            double u = a[i*ln + k];
+            for(j = 0; j < nrhs; j++) b[i*lr + j] -= u*b[k*lr + j];
+         }
+         dum = 1.0/a[i*ln + i];
+         for(j = 0; j < nrhs; j++) b[i*lr + j] *= dum;
+      }
+      if(k0 > 0) {
+         lu_update(k0, nrhs, kn - k0, a + k0, ln,
+                   b + k0*lr, lr, b, lr);
+      }
+   }
+} // End: function lubksb()
+
     /*
     ** The function
     **                 tqli()
@@ -429,17 +701,18 @@ void lubksb(double **a, int n, int *indx, double *b)
     ** eigenvectors of a matrix reduced by tred2() are required,
     ** then z[][] on input is the matrix output from tred2().
     ** On output, the k'th column returns the normalized eigenvector
-    ** corresponding to d[k]. 
+    ** corresponding to d[k]. Returns 0 on success and 1 if an
+    ** eigenvalue needs more than 30 iterations.
     ** The function is modified from the version in Numerical recipe.
     */
 
-void tqli(double *d, double *e, int n, double **z)
+int tqli(double *d, double *e, int n, double **z)
 {
-   register int   m,l,iter,i,k;
+   int            m,l,iter,i,k;
    double         s,r,p,g,f,dd,c,b;
 
    for(i = 1; i < n; i++) e[i-1] = e[i];
-   e[n] = 0.0;
+   if(n > 0) e[n-1] = 0.0;
    for(l = 0; l < n; l++) {
       iter = 0;
       do {
@@ -448,10 +721,7 @@ void tqli(double *d, double *e, int n, double **z)
             if((double)(fabs(e[m])+dd) == dd) break;
          }
          if(m != l) {
-            if(iter++ == 30) {
-               printf("\n\nToo many iterations in tqli.\n");
-               exit(1);
-            }
+            if(iter++ == 30) return 1;   // too many iterations
             g = (d[l+1] - d[l])/(2.0 * e[l]);
             r = pythag(g,1.0);
             g = d[m]-d[l]+e[l]/(g+SIGN(r,g));
@@ -485,6 +755,7 @@ void tqli(double *d, double *e, int n, double **z)
          } /* end if-loop for m != 1 */
       } while(m != l);
    } /* end l-loop */
+   return 0;
 } /* End: function tqli(), (C) Copr. 1986-92 Numerical Recipes Software )%. */
    
     /*
@@ -500,7 +771,7 @@ void tqli(double *d, double *e, int n, double **z)
 
  void tred2(double **a, int n, double *d, double *e)
  {
-    register int    l,k,j,i;
+    int             l,k,j,i;
     double          scale,hh,h,g,f;
 
     for(i = n - 1; i > 0; i--) {
@@ -576,14 +847,247 @@ void tqli(double *d, double *e, int n, double **z)
     }
  } // End: function tred2(), (C) Copr. 1986-92 Numerical Recipes Software )
 
+    /*
+    ** The function
+    **                tred2()
+    ** as tred2() above, but for a symmetric matrix stored contiguously row
+    ** by row in a[0,..,n*n - 1], with both triangles set. d[] and e[] are
+    ** returned as above. If vectors is nonzero, a[] is replaced by the
+    ** orthogonal matrix Q effecting the transformation, to be passed on
+    ** to tqli(); otherwise a[] is destroyed and the O(n^3) formation of Q
+    ** is skipped. The reduction is blocked as in LAPACK's dsytrd: for a
+    ** panel of LU_NB columns the Householder vectors v and the vectors w
+    ** of the rank-2 updates A = A - v w^T - w v^T are found while the
+    ** updates are deferred, and the trailing matrix then gets them all at
+    ** once through lu_update(). Q is formed by backward accumulation of
+    ** the reflections, with contiguous row operations.
+    */
+
+void tred2(double *a, int n, double *d, double *e, int vectors)
+{
+   int      i, j, jj, k0, kn, kb, q, nb = LU_NB;
+   long     ln = n, m;
+   double   alpha, beta, sigma, tau, dot, wv, vv;
+   double   *x, *v, *p, *taus, *vr, *wr, *vt, *wt;
+
+  x = new(nothrow) double [4*(long) n*(nb + 1)];
+  if(!x) {
+    printf("\n\nError in function tred2():");
+    printf("\nNot enough memory for work space\n");
+    exit(1);
+  }
+  v    = x + n;                 // Householder vector of the current step
+  p    = v + n;                 // A v, then w
+  taus = p + n;
+  vr   = taus + n;              // panel of v's, n x nb and nb x n
+  wr   = vr + n*(long) nb;      // panel of w's, n x nb and nb x n
+  vt   = wr + n*(long) nb;
+  wt   = vt + n*(long) nb;
+
+   for(k0 = 0; k0 < n; k0 += nb) {      // loop over panels
+      kn = min(k0 + nb, n);
+      kb = kn - k0;
+      for(i = 0; i < n*(long) nb; i++) vr[i] = wr[i] = vt[i] = wt[i] = 0.0;
+
+      for(j = k0; j < kn; j++) {
+         jj = j - k0;
+
+                  // row j of the matrix with the deferred updates applied
+
+         for(i = j; i < n; i++) x[i] = a[j*ln + i];
+         for(q = 0; q < jj; q++) {
+            double wj = wr[j*(long) nb + q], vj = vr[j*(long) nb + q];
+            for(i = j; i < n; i++) x[i] -= vt[q*ln + i]*wj + wt[q*ln + i]*vj;
+         }
+         d[j] = x[j];
+         taus[j] = 0.0;
+         if(j == n - 1) break;
+
+                  // reflection I - tau v v^T taking x[j+1..n-1] to beta e_1
+
+         alpha = x[j+1];
+         sigma = 0.0;
+         for(i = j + 2; i < n; i++) sigma += x[i]*x[i];
+         for(i = 0; i < n; i++) v[i] = 0.0;
+         v[j+1] = 1.0;
+         if(sigma == 0.0) {
+            beta = alpha;
+            tau  = 0.0;
+         } else {
+            beta = sqrt(alpha*alpha + sigma);
+            if(alpha > 0.0) beta = -beta;
+            tau  = (beta - alpha)/beta;
+            for(i = j + 2; i < n; i++) v[i] = x[i]/(alpha - beta);
+         }
+         e[j+1]  = beta;
+         taus[j] = tau;
+         for(i = j + 2; i < n; i++) a[j*ln + i] = v[i];   // kept for Q
+
+                  // w = p - (tau/2)(p.v) v with p = tau A v, A deferred
+
+         for(i = j + 1; i < n; i++) {
+            const double *ai = a + i*ln;
+            dot = 0.0;
+            for(q = j + 1; q < n; q++) dot += ai[q]*v[q];
+            p[i] = dot;
+         }
+         for(q = 0; q < jj; q++) {
+            wv = vv = 0.0;
+            for(i = j + 1; i < n; i++) {
+               wv += wt[q*ln + i]*v[i];
+               vv += vt[q*ln + i]*v[i];
+            }
+            for(i = j + 1; i < n; i++) p[i] -= vt[q*ln + i]*wv + wt[q*ln + i]*vv;
+         }
+         dot = 0.0;
+         for(i = j + 1; i < n; i++) {
+            p[i] *= tau;
+            dot  += p[i]*v[i];
+         }
+         for(i = j + 1; i < n; i++) {
+            p[i] -= 0.5*tau*dot*v[i];
+            vr[i*(long) nb + jj] = vt[jj*ln + i] = v[i];
+            wr[i*(long) nb + jj] = wt[jj*ln + i] = p[i];
+         }
+      } // end j-loop over the panel
+
+      m = n - kn;                        // trailing matrix gets the updates
+      if(m > 0) {
+         lu_update(m, m, kb, vr + kn*(long) nb, nb, wt + kn, ln,
+                   a + kn*ln + kn, ln);
+         lu_update(m, m, kb, wr + kn*(long) nb, nb, vt + kn, ln,
+                   a + kn*ln + kn, ln);
+      }
+   } // end loop over panels
+   e[0] = 0.0;
+
+   if(vectors) {                         // Q = H_0 H_1 ... H_(n-2)
+      for(j = n - 2; j >= 0; j--) {
+         for(i = j + 2; i < n; i++) v[i] = a[j*ln + i];
+         v[j+1] = 1.0;
+         a[(j+1)*ln + j+1] = 1.0;      // row and column j+1 of identity
+         for(i = j + 2; i < n; i++) a[(j+1)*ln + i] = a[i*ln + j+1] = 0.0;
+         tau = taus[j];
+         if(tau == 0.0) continue;
+         for(i = j + 1; i < n; i++) p[i] = 0.0;
+         for(i = j + 1; i < n; i++) {   // p = v^T Q
+            const double *ai = a + i*ln;
+            for(q = j + 1; q < n; q++) p[q] += v[i]*ai[q];
+         }
+         for(i = j + 1; i < n; i++) {   // Q = Q - tau v p^T
+            double *ai = a + i*ln, f = tau*v[i];
+            for(q = j + 1; q < n; q++) ai[q] -= f*p[q];
+         }
+      }
+      for(i = 1; i < n; i++) a[i] = a[i*ln] = 0.0;
+      a[0] = 1.0;
+   }
+
+   delete [] x;   // release local memory
+
+} // End: function tred2()
+
+    /*
+    ** The function
+    **                 tqli()
+    ** as tqli() above, but with z[] stored contiguously row by row, e.g. Q
+    ** from the contiguous tred2(), and the k'th column returning the
+    ** eigenvector of d[k]. With z = (double *) 0 only the eigenvalues are
+    ** found, which takes O(n^2) operations. The rotations are applied to
+    ** rows of the transpose of z, which are contiguous, and z is
+    ** transposed back before returning, also on failure. Returns 0 on
+    ** success and 1 if an eigenvalue needs more than 30 iterations.
+    */
+
+static void transpose(double *z, int n)
+{
+   int      i, k;
+   long     ln = n;
+   double   temp;
+
+   for(i = 0; i < n; i++) {
+      for(k = i + 1; k < n; k++) {
+         temp = z[i*ln + k]; z[i*ln + k] = z[k*ln + i]; z[k*ln + i] = temp;
+      }
+   }
+} // End: function transpose()
+
+int tqli(double *d, double *e, int n, double *z)
+{
+   int      m, l, iter, i, k;
+   long     ln = n;
+   double   s, r, p, g, f, dd, c, b;
+
+   if(z) transpose(z, n);                 // eigenvectors to rows
+
+   for(i = 1; i < n; i++) e[i-1] = e[i];
+   if(n > 0) e[n-1] = 0.0;
+   for(l = 0; l < n; l++) {
+      iter = 0;
+      do {
+         for(m = l; m < n-1; m++) {
+            dd = fabs(d[m]) + fabs(d[m+1]);
+            if((double)(fabs(e[m])+dd) == dd) break;
+         }
+         if(m != l) {
+            if(iter++ == 30) {
+               if(z) transpose(z, n);     // back to columns, as far as done
+               return 1;
+            }
+            g = (d[l+1] - d[l])/(2.0 * e[l]);
+            r = pythag(g,1.0);
+            g = d[m]-d[l]+e[l]/(g+SIGN(r,g));
+            s = c = 1.0;
+            p = 0.0;
+            for(i = m-1; i >= l; i--) {
+               f      = s * e[i];
+               b      = c*e[i];
+               e[i+1] = (r=pythag(f,g));
+               if(r == 0.0) {
+                  d[i+1] -= p;
+                  e[m]    = 0.0;
+                  break;
+               }
+               s      = f/r;
+               c      = g/r;
+               g      = d[i+1] - p;
+               r      = (d[i] - g) * s + 2.0 * c * b;
+               d[i+1] = g + (p = s * r);
+               g      = c * r - b;
+               if(z) {
+                  double *zi = z + i*ln, *zi1 = zi + ln;
+                  for(k = 0; k < n; k++) {
+                     f      = zi1[k];
+                     zi1[k] = s * zi[k] + c * f;
+                     zi[k]  = c * zi[k] - s * f;
+                  }
+               }
+            } /* end i-loop */
+            if(r == 0.0 && i >= l) continue;
+            d[l] -= p;
+            e[l]  = g;
+            e[m]  = 0.0;
+         } /* end if-loop for m != 1 */
+      } while(m != l);
+   } /* end l-loop */
+
+   if(z) transpose(z, n);                 // eigenvectors back to columns
+   return 0;
+} // End: function tqli()
+
 
 double pythag(double a, double b)
 {
-  double absa,absb;
+  double absa,absb,r;
   absa=fabs(a);
   absb=fabs(b);
-  if (absa > absb) return absa*sqrt(1.0+SQR(absb/absa));
-  else return (absb == 0.0 ? 0.0 : absb*sqrt(1.0+SQR(absa/absb)));
+  if (absa > absb) {
+    r = absb/absa;
+    return absa*sqrt(1.0+r*r);
+  }
+  if (absb == 0.0) return 0.0;
+  r = absa/absb;
+  return absb*sqrt(1.0+r*r);
 }
 // End: function pythag(), (C) Copr. 1986-92 Numerical Recipes Software )%.
 
@@ -594,69 +1098,104 @@ double pythag(double a, double b)
        ** takes the lower and upper limits of integration x1, x2, calculates
        ** and return the abcissas in x[0,...,n - 1] and the weights in w[0,...,n - 1]
        ** of length n of the Gauss--Legendre n--point quadrature formulae.
+       ** The abcissas and weights on [-1, 1] are taken from gauleg_table(),
+       ** so they are only computed on the first call for each n.
        */
 
 void gauleg(double x1, double x2, double x[], double w[], int n)
 {
-   int         m,j,i;
-   double      z1,z,xm,xl,pp,p3,p2,p1;
-   double      const  pi = 3.14159265359; 
-   double      *x_low, *x_high, *w_low, *w_high;
+   int         i;
+   double      xm, xl;
+   const double *t = gauleg_table(n);
 
-   m  = (n + 1)/2;                             // roots are symmetric in the interval
    xm = 0.5 * (x2 + x1);
    xl = 0.5 * (x2 - x1);
+   for(i = 0; i < n; i++) {
+      x[i] = xm + xl * t[i];
+      w[i] = xl * t[n + i];
+   }
+} // End_ function gauleg()
+
+       /*
+       ** The function 
+       **              gauleg_compute()
+       ** finds the abcissas x[0,...,n - 1] in increasing order and the weights
+       ** w[0,...,n - 1] of the n-point Gauss--Legendre rule on [-1, 1] by
+       ** Newton's method on the Legendre polynomial, as gauleg() used to do
+       ** on every call. The weight is computed from the derivative at the
+       ** converged root. The work is O(n^2) and done once per n.
+       */
 
-   x_low  = x;                                       // pointer initialization
-   x_high = x + n - 1;
-   w_low  = w;
-   w_high = w + n - 1;
+static void gauleg_compute(int n, double x[], double w[])
+{
+   int         m, j, i, iter;
+   double      z1, z, pp, p3, p2, p1;
+   double      const  pi = 3.14159265358979323846;
 
-   for(i = 1; i <= m; i++) {                             // loops over desired roots
+   m = (n + 1)/2;                             // roots are symmetric
+   for(i = 1; i <= m; i++) {
       z = cos(pi * (i - 0.25)/(n + 0.5));
+      for(iter = 0; iter < 100; iter++) {
+         p1 = 1.0;
+         p2 = 0.0;
+         for(j = 1; j <= n; j++) {            // recurrence for P_n(z)
+            p3 = p2;
+            p2 = p1;
+            p1 = ((2.0 * j - 1.0) * z * p2 - (j - 1.0) * p3)/j;
+         }
+         pp = n * (z * p1 - p2)/(z * z - 1.0);
+         z1 = z;
+         z  = z1 - p1/pp;                     // Newton's method
+         if(fabs(z - z1) <= 1.0e-15 * max(fabs(z), 1.0e-3)) break;
+      }
+      p1 = 1.0;                               // P_n'(z) at the root
+      p2 = 0.0;
+      for(j = 1; j <= n; j++) {
+         p3 = p2;
+         p2 = p1;
+         p1 = ((2.0 * j - 1.0) * z * p2 - (j - 1.0) * p3)/j;
+      }
+      pp = n * (z * p1 - p2)/(z * z - 1.0);
 
-           /*
-	   ** Starting with the above approximation to the ith root
-           ** we enter the mani loop of refinement bt Newtons method.
-           */
+      x[i-1] = -z;
+      x[n-i] = z;
+      w[i-1] = w[n-i] = 2.0/((1.0 - z * z) * pp * pp);
+   }
+} // End_ function gauleg_compute()
 
-      do {
-         p1 =1.0;
-	 p2 =0.0;
-
-   	   /*
-	   ** loop up recurrence relation to get the
-           ** Legendre polynomial evaluated at x
-           */
-
-	 for(j = 1; j <= n; j++) {
-	    p3 = p2;
-	    p2 = p1;
-	    p1 = ((2.0 * j - 1.0) * z * p2 - (j - 1.0) * p3)/j;
-	 }
+       /*
+       ** The function 
+       **              gauleg_table()
+       ** returns the n-point Gauss--Legendre rule on [-1, 1] as a table of
+       ** 2n numbers, the abcissas in increasing order followed by their
+       ** weights. Each table is computed once and kept for the rest of the
+       ** run, so the pointer stays valid. The function is thread-safe;
+       ** tables for n < GAULEG_SMALL are found without locking.
+       */
 
-	   /*
-	   ** p1 is now the desired Legrendre polynomial. Next compute
-           ** ppp its derivative by standard relation involving also p2,
-           ** polynomial of one lower order.
-           */
- 
-	 pp = n * (z * p1 - p2)/(z * z - 1.0);
-	 z1 = z;
-	 z  = z1 - p1/pp;                   // Newton's method
-      } while(fabs(z - z1) > ZERO);
-
-          /* 
-	  ** Scale the root to the desired interval and put in its symmetric
-          ** counterpart. Compute the weight and its symmetric counterpart
-          */
-
-      *(x_low++)  = xm - xl * z;
-      *(x_high--) = xm + xl * z;
-      *w_low      = 2.0 * xl/((1.0 - z * z) * pp * pp);
-      *(w_high--) = *(w_low++);
-   }
-} // End_ function gauleg()
+static const int GAULEG_SMALL = 256;
+static atomic<const double*> gauleg_small[GAULEG_SMALL];
+static map<int, vector<double> > gauleg_tables;
+static mutex gauleg_mutex;
+
+const double* gauleg_table(int n)
+{
+  if(n < 1) return 0;
+  if(n < GAULEG_SMALL) {
+    const double *t = gauleg_small[n].load(memory_order_acquire);
+    if(t) return t;
+  }
+
+  lock_guard<mutex> lock(gauleg_mutex);
+  vector<double>& table = gauleg_tables[n];
+  if(table.empty()) {
+    vector<double> t(2*n);
+    gauleg_compute(n, &t[0], &t[n]);
+    table.swap(t);
+  }
+  if(n < GAULEG_SMALL) gauleg_small[n].store(&table[0], memory_order_release);
+  return &table[0];
+} // End_ function gauleg_table()
 
 
 /*
@@ -687,9 +1226,10 @@ inline void jacobi_rot(double** a, double s, double tau, int i, int j, int k, in
        ** A  by use of the Jacobi method.
        ** It puts the eigenvalues in d and eigenvectors in v.
        ** n is an integer denoting the size of A
+       ** Returns 0 on convergence and 1 after 50 sweeps without.
        ** The function is as in the Numerical recipe
        */
-void jacobi(double** a, double* d, double** v, int n, int &nrot){
+int jacobi(double** a, double* d, double** v, int n, int &nrot){
   int i,j, ip, iq;
   double tresh, theta, tau, t, sm, s, h, g, c;
   
@@ -718,7 +1258,9 @@ void jacobi(double** a, double* d, double** v, int n, int &nrot){
       }
     }
     if(sm == 0.0){
-      return;                  //The normal return at convergence
+      delete [] b;
+      delete [] z;
+      return 0;                //The normal return at convergence
     }
     if(i < 4){
       tresh = 0.2 * sm/(n*n);  //On the first four sweeps
@@ -774,8 +1316,227 @@ void jacobi(double** a, double* d, double** v, int n, int &nrot){
       z[ip] = 0.0;
     }
   }
-  printf("\n\nToo many iterations in routine jacobi.\n");
-  exit(1); 
+  delete [] b;
+  delete [] z;
+  return 1;                    //Too many iterations
+}//End function jacobi()
+
+       /*
+       ** The class
+       **              JacobiBarrier
+       ** lets the threads of the parallel jacobi() below wait for each
+       ** other between the phases of a round of rotations.
+       */
+
+class JacobiBarrier
+{
+public:
+  JacobiBarrier(int n) : n_(n), waiting_(0), generation_(0) {}
+
+  void wait() {
+    unique_lock<mutex> lock(m_);
+    long gen = generation_;
+    if (++waiting_ == n_) {
+      waiting_ = 0;
+      generation_++;
+      cv_.notify_all();
+    } else {
+      cv_.wait(lock, [this, gen]() { return generation_ != gen; });
+    }
+  }
+
+private:
+  mutex m_;
+  condition_variable cv_;
+  int n_, waiting_;
+  long generation_;
+};
+
+struct JacobiState
+{
+  double *a, *w;              // matrix and transposed eigenvectors, n x n
+  int n, m;                   // m = n rounded up to even
+  int nthreads, maxsweeps;
+  vector<double> c, s;        // rotation of each pair in the current round
+  vector<char> rotated;       // whether pair k was rotated in this round
+  JacobiBarrier barrier;
+  atomic<long> count[2];      // rotations in a sweep, by parity of sweep
+  long nrot;
+  int status;
+
+  JacobiState(int nthreads) : barrier(nthreads) {}
+};
+
+       /*
+       ** The function
+       **              jacobi_worker()
+       ** is run by thread t of the parallel jacobi(). In round r of a sweep
+       ** the indices 0,..,m-1 are paired by the round-robin (circle)
+       ** ordering: m-1 is paired with r, and r+k with r-k (mod m-1) for
+       ** k = 1,..,m/2-1. The pairs are disjoint, so their rotations are
+       ** independent. Thread t first finds the rotations of its share of
+       ** the pairs and applies them to whole rows p and q of a and w,
+       ** which are contiguous and vectorized. After a barrier it applies
+       ** all rotations of the round to columns p and q in its share of the
+       ** rows of a, and the round ends with a second barrier.
+       */
+
+static void jacobi_worker(JacobiState& st, int t)
+{
+  int i, j, k, r, p, q, sweep;
+  int n = st.n, m = st.m, npairs = st.m/2, T = st.nthreads;
+  int k0 = t*npairs/T, k1 = (t + 1)*npairs/T;
+  int i0 = t*n/T, i1 = (t + 1)*n/T;
+  long ln = n, mine;
+  double *a = st.a, *w = st.w;
+  double app, aqq, apq, g, h, theta, tt, c, s, x, y;
+  vector<int> P(npairs), Q(npairs), pair(m);
+
+  for(sweep = 1; sweep <= st.maxsweeps; sweep++){
+    mine = 0;
+    for(r = 0; r < m - 1; r++){
+      for(k = 0; k < npairs; k++){          // pairs of this round
+        p = k == 0 ? m - 1 : (r + k) % (m - 1);
+        q = (r - k + m - 1) % (m - 1);
+        P[k] = min(p, q);
+        Q[k] = max(p, q);
+        pair[p] = pair[q] = k;
+      }
+
+      for(k = k0; k < k1; k++){             // rotations and rows p, q
+        p = P[k];
+        q = Q[k];
+        st.rotated[k] = 0;
+        if(q >= n) continue;                // paired with the padding index
+        app = a[p*ln + p];
+        aqq = a[q*ln + q];
+        apq = a[p*ln + q];
+        g = 100.0*fabs(apq);
+        if((fabs(app) + g) == fabs(app) && (fabs(aqq) + g) == fabs(aqq)) continue;
+        h = aqq - app;
+        if((fabs(h) + g) == fabs(h)){
+          tt = apq/h;
+        }else{
+          theta = 0.5*h/apq;
+          tt = 1.0/(fabs(theta) + sqrt(1.0 + theta*theta));
+          if(theta < 0.0) tt = -tt;
+        }
+        c = 1.0/sqrt(1.0 + tt*tt);
+        s = tt*c;
+        st.c[k] = c;
+        st.s[k] = s;
+        st.rotated[k] = 1;
+        mine++;
+        double *ap = a + p*ln, *aq = a + q*ln, *wp = w + p*ln, *wq = w + q*ln;
+        for(j = 0; j < n; j++){
+          x = ap[j];
+          y = aq[j];
+          ap[j] = c*x - s*y;
+          aq[j] = s*x + c*y;
+        }
+        for(j = 0; j < n; j++){
+          x = wp[j];
+          y = wq[j];
+          wp[j] = c*x - s*y;
+          wq[j] = s*x + c*y;
+        }
+      }
+      st.barrier.wait();
+
+      for(i = i0; i < i1; i++){             // columns p, q of own rows
+        double *ai = a + i*ln;
+        for(k = 0; k < npairs; k++){
+          if(!st.rotated[k]) continue;
+          p = P[k];
+          q = Q[k];
+          c = st.c[k];
+          s = st.s[k];
+          x = ai[p];
+          y = ai[q];
+          ai[p] = c*x - s*y;
+          ai[q] = s*x + c*y;
+        }
+        k = pair[i];                        // annihilated element is exactly 0
+        if(st.rotated[k]) ai[P[k] + Q[k] - i] = 0.0;
+      }
+      st.barrier.wait();
+    }
+
+    st.count[sweep & 1] += mine;
+    st.barrier.wait();
+    long total = st.count[sweep & 1];
+    if(t == 0){
+      st.count[(sweep + 1) & 1] = 0;
+      st.nrot += total;
+    }
+    if(total == 0){                         // no rotation in a whole sweep
+      if(t == 0) st.status = 0;
+      return;
+    }
+  }
+}
+
+       /*
+       ** The function
+       **              jacobi()
+       ** Computes the eigenvalues and eigenvectors of the square symmetric
+       ** matrix a[0,..,n*n - 1], stored contiguously row by row, by cyclic
+       ** Jacobi sweeps in round-robin order run by nthreads threads. The
+       ** eigenvalues are returned in d and the eigenvectors as the columns
+       ** of v, stored as a; a is destroyed. nrot returns the number of
+       ** rotations. Rotations are skipped when the off-diagonal element is
+       ** negligible against both diagonal elements, as in the serial
+       ** version, and the iteration stops after a sweep with no rotation.
+       ** Returns 0 on convergence and 1 if maxsweeps sweeps were not enough.
+       */
+
+int jacobi(double *a, double *d, double *v, int n, int &nrot, int nthreads,
+           int maxsweeps)
+{
+  int i, j, t;
+  long ln = n;
+  double temp;
+
+  if(nthreads < 1) nthreads = 1;
+  if(nthreads > n/2) nthreads = max(n/2, 1);
+
+  JacobiState st(nthreads);
+  st.a = a;
+  st.w = v;
+  st.n = n;
+  st.m = n + (n & 1);
+  st.nthreads = nthreads;
+  st.maxsweeps = maxsweeps;
+  st.c.resize(st.m/2);
+  st.s.resize(st.m/2);
+  st.rotated.resize(st.m/2);
+  st.count[0] = 0;
+  st.count[1] = 0;
+  st.nrot = 0;
+  st.status = 1;
+
+  for(i = 0; i < n; i++){
+    for(j = 0; j < n; j++) v[i*ln + j] = 0.0;   // v = identity
+    v[i*ln + i] = 1.0;
+  }
+
+  vector<thread> threads;
+  for(t = 1; t < nthreads; t++){
+    threads.push_back(thread(jacobi_worker, ref(st), t));
+  }
+  jacobi_worker(st, 0);
+  for(t = 0; t < nthreads - 1; t++) threads[t].join();
+
+  for(i = 0; i < n; i++){
+    d[i] = a[i*ln + i];
+    for(j = i + 1; j < n; j++){                 // eigenvectors to columns
+      temp = v[i*ln + j];
+      v[i*ln + j] = v[j*ln + i];
+      v[j*ln + i] = temp;
+    }
+  }
+  nrot = st.nrot;
+  return st.status;
 }//End function jacobi()
 
 
@@ -786,23 +1547,19 @@ void jacobi(double** a, double* d, double** v, int n, int &nrot){
          ** y_i = f(x_i) with x_0 < x_1 < .. < x_(n - 1) together with yp_1 and yp2
          ** for first derivatives  f(x) at x_0 and x_(n-1), respectively. Then the
          ** function returns y2[0,..,n-1] which contanin the second derivatives of
-         ** f(x_i)at each point x_i. If yp1 and/or yp2 is larger than the constant
-         ** INFINITY the function will put corresponding second derivatives to zero.
+         ** f(x_i)at each point x_i. If yp1 and/or yp2 is larger than 0.99e30,
+         ** e.g. INFINITY, the function will put corresponding second derivatives
+         ** to zero, giving a natural spline. The scratch array u[] of length n
+         ** is owned by the caller, so no memory is allocated here.
          */ 
 
-void spline(double x[], double y[], int n, double yp1, double yp2, double y2[])
+void spline(double x[], double y[], int n, double yp1, double yp2, double y2[],
+            double *u)
 { 
    int          i,k;
-   double       p,qn,sig,un,*u;
+   double       p,qn,sig,un;
 
-  u = new(nothrow) double [n];
-  if(!u) {
-    printf("\n\nError in function spline():");
-    printf("\nNot enough memory for u[%d]\n",n);
-    exit(1);
-  }
-
-   if(yp1 > INFINITY)  y2[0] = u[0] = 0.0;
+   if(yp1 > 0.99e30)  y2[0] = u[0] = 0.0;
    else {
       y2[0] = -0.5;
       u[0]  = (3.0/(x[1] - x[0])) * ((y[1] - y[0])/(x[1] - x[0]) - yp1);
@@ -814,7 +1571,7 @@ void spline(double x[], double y[], int n, double yp1, double yp2, double y2[])
       u[i]  = (y[i + 1] - y[i])/(x[i + 1] - x[i]) - (y[i] - y[i - 1])/(x[i] - x[i - 1]);
       u[i]  = (6.0 * u[i]/(x[i + 1] - x[i - 1]) - sig*u[i - 1])/p;
    }
-   if(yp2 > INFINITY)  qn = un = ZERO;
+   if(yp2 > 0.99e30)  qn = un = 0.0;
    else {
       qn = 0.5;
       un = (3.0/(x[n - 1] - x[n - 2])) * (yp2 - (y[n - 1] - y[n - 2])/(x[n - 1] - x[n - 2]));
@@ -824,7 +1581,29 @@ void spline(double x[], double y[], int n, double yp1, double yp2, double y2[])
    for(k = n - 2; k >= 0; k--) {
       y2[k] = y2[k]*y2[k+1]+u[k];
    }
-   delete [] u;            ;
+
+}  // End: function spline()
+
+         /*
+	 ** The function 
+         **           spline()
+         ** as above, but reserves the scratch memory itself on every call.
+         */ 
+
+void spline(double x[], double y[], int n, double yp1, double yp2, double y2[])
+{ 
+   double       *u;
+
+  u = new(nothrow) double [n];
+  if(!u) {
+    printf("\n\nError in function spline():");
+    printf("\nNot enough memory for u[%d]\n",n);
+    exit(1);
+  }
+
+  spline(x, y, n, yp1, yp2, y2, u);
+
+  delete [] u;            // release local memory
 
 }  // End: function spline()
 
@@ -873,7 +1652,7 @@ void splint(double xa[], double ya[], double y2a[], int n, double x, double *y)
 
 void polint(double xa[], double ya[], int n, double x, double *y, double *dy)
 {
-  int      i, m, ns = 1;
+  int      i, m, ns = 0;
   double   den,dif,dift,ho,hp,w;
   double   *c,*d;
   
@@ -902,21 +1681,21 @@ void polint(double xa[], double ya[], int n, double x, double *y, double *dy)
       d[i] = ya[i];
    }
    *y = ya[ns--];
-   for(m = 0; m < (n - 1); m++) {
+   for(m = 1; m < n; m++) {
       for(i = 0; i < n - m; i++) {
          ho = xa[i] - x;
          hp = xa[i + m] - x;
          w  = c[i + 1] - d[i];
-         if((den = ho - hp) < ZERO) {
+         if((den = ho - hp) == 0.0) {
             printf("\n\n Error in function polint(): ");
-            printf("\nden = ho - hp = %4.1E -- too small\n",den);
+            printf("\nTwo equal values in xa[]\n");
             exit(1);
 	 }
          den  = w/den;
          d[i] = hp * den;
          c[i] = ho * den;
       }
-      *y += (*dy = (2 * ns < (n - m) ? c[ns + 1] : d[ns--]));
+      *y += (*dy = (2 * (ns + 1) < (n - m) ? c[ns + 1] : d[ns--]));
    }
    delete [] d;
    delete [] c;
@@ -1389,12 +2168,12 @@ double trapezoidal_rule(double a, double b, int n, double (*func)(double))
 double rectangle_rule(double a, double b, int n, double (*func)(double))
 {
       double rectangle_sum;
-      double fa, fb, x, step;
+      double x, step;
       int    j;
       step=(b-a)/((double) n);
       rectangle_sum=0.;
-      for (j = 0; j <= n; j++){
-         x = (j+0.5)*step;   // midpoint of a given rectangle
+      for (j = 0; j < n; j++){
+         x = a + (j+0.5)*step;   // midpoint of a given rectangle
          rectangle_sum+=(*func)(x);   //  add value of function.
       }
       rectangle_sum *= step;  //  multiply with step length.
@@ -4,9 +4,13 @@
      * for the library function common for all C programs.
      */
 
+#ifndef LIB_H
+#define LIB_H
+
      // Standard ANSI-C++ include files 
 
 
+#include <algorithm>
 #include <iostream>
 #include <new>
 #include <cstdio>
@@ -21,12 +25,6 @@ using namespace std;
 #define   ZERO       1.0E-10
 #define   UL         unsigned long
 
-         /* a macro used in function pythag() */
-
-static float sqrarg;
-#define SQR(a) ((sqrarg = (a)) == 0.0 ? 0.0 : sqrarg * sqrarg)
-
-
      /* Macro definitions for integer arguments only */
 
 #define   SIGN(a,b) ((b)<0 ? -fabs(a) : fabs(a))
@@ -37,22 +35,36 @@ void  **matrix(int, int, int);
 void free_matrix(void **);
 void rk4(double *, double *, int, double, double, double  *,
 	           void (*derivs)(double, double *, double *));
+void rk4(double *, double *, int, double, double, double  *,
+	           void (*derivs)(double, double *, double *), double *);
 void ludcmp(double **, int, int *, double*);
 void lubksb(double **, int, int *, double *);
-void tqli(double *, double *, int, double **);
+void ludcmp(double *, int, int *, double *);
+void lubksb(double *, int, int *, double *, int);
+int tqli(double *, double *, int, double **);
 void tred2(double **, int, double *, double *);
+int tqli(double *, double *, int, double *);
+void tred2(double *, int, double *, double *, int vectors = 1);
 double pythag(double, double);
 void gauleg(double, double, double *, double *, int);
-void jacobi(double** a, double* d, double** v, int n, int& nrot);
+const double* gauleg_table(int);
+int jacobi(double** a, double* d, double** v, int n, int& nrot);
+int jacobi(double *a, double *d, double *v, int n, int& nrot, int nthreads = 1,
+           int maxsweeps = 50);
 double rectangle_rule(double, double, int, double (*func)(double));
 double trapezoidal_rule(double, double, int, double (*func)(double));
 void spline(double *, double *, int, double, double, double *);
+void spline(double *, double *, int, double, double, double *, double *);
 void splint(double *, double *, double *, int, double, double *);
 void polint(double *, double *, int, double, double *, double *);
+double rtbis(double (*func)(double), double, double, double);
+double rtsec(double (*func)(double), double, double, double);
+double rtnewt(void (*funcd)(double, double *, double *), double, double, double);
+double zbrent(double (*func)(double), double, double, double);
+// ran0()-ran3() keep state in statics and are not thread-safe; see philox.h
 double ran0(long *);
 double ran1(long *);
 double ran2(long *);
 double ran3(long *);
 
-
-
+#endif
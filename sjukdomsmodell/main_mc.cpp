@@ -5,7 +5,16 @@
 #include <vector>
 #include <cmath>
 #include <random>
+#include <thread>
+#include <limits>
+#include <sstream>
 #include "lib.h"
+#include "philox.h"
+#include "steady_state.h"
+#include "thread_pool.h"
+#include "sweep.h"
+#include "trajectory.h"
+#include "trajectory_store.h"
 
 using namespace std;
 
@@ -16,20 +25,30 @@ public:
   double* S;  // susceptible array
   double* I;  // infected array
   double* R;  // recovered array
-  int a;      // rate of transmission
-  int b;      // rate of recovery
+  double a;   // rate of transmission
+  double b;   // rate of recovery
   float c;    // rate of immunity loss
 
   Population() {
+    S = I = R = nullptr;
   }
 
+  // The arrays belong to a TrajectoryStore, so populations are moved,
+  // never copied
+  Population(const Population&) = delete;
+  Population& operator=(const Population&) = delete;
+  Population(Population&&) = default;
+  Population& operator=(Population&&) = default;
+
   ~Population() {}
 
-  void initiate(double S0, double I0, double R0, int transm_rate,
-                int recov_rate, float imloss_rate, int steps) {
-    S = new double[steps]; S[0] = S0;
-    I = new double[steps]; I[0] = I0;
-    R = new double[steps]; R[0] = R0;
+  void initiate(double S0, double I0, double R0, double transm_rate,
+                double recov_rate, float imloss_rate, int steps,
+                TrajectoryStore& store) {
+    double* block = store.take(3*(size_t) steps);
+    S = block;           S[0] = S0;
+    I = block + steps;   I[0] = I0;
+    R = block + 2*steps; R[0] = R0;
     N = S[0] + I[0] + R[0];
     a = transm_rate;
     b = recov_rate;
@@ -47,8 +66,192 @@ public:
   double dRdt(double s, double i, double r) {
     return b*i - c*r;
   }
+
+  // The rates for steady_state.h, which conserve S + I + R = N
+  SIRSParameters parameters() const {
+    SIRSParameters p = {(double) N, a, b, c, 0.0, 0.0, 0.0, 0.0};
+    return p;
+  }
+};
+
+// Per-time-step mean and variance of an ensemble of trajectories,
+// accumulated online with Welford's algorithm
+class Ensemble
+{
+public:
+  long n;                            // number of samples added
+  vector<double> meanS, meanI, meanR;
+  vector<double> m2S, m2I, m2R;      // sums of squared deviations
+  double inv_n;
+
+  Ensemble(int ntimes) : n(0), meanS(ntimes, 0.0), meanI(ntimes, 0.0),
+    meanR(ntimes, 0.0), m2S(ntimes, 0.0), m2I(ntimes, 0.0), m2R(ntimes, 0.0),
+    inv_n(0.0) {
+  }
+
+  int ntimes() const {
+    return meanS.size();
+  }
+
+  // Must be called once before the time steps of a new sample are added
+  void new_sample() {
+    n += 1;
+    inv_n = 1.0/n;
+  }
+
+  // Adding the state at time step i of the current sample
+  void add(int i, double S, double I, double R) {
+    double dS = S - meanS[i];
+    double dI = I - meanI[i];
+    double dR = R - meanR[i];
+    meanS[i] += dS*inv_n;
+    meanI[i] += dI*inv_n;
+    meanR[i] += dR*inv_n;
+    m2S[i] += dS*(S - meanS[i]);
+    m2I[i] += dI*(I - meanI[i]);
+    m2R[i] += dR*(R - meanR[i]);
+  }
+
+  // Merging with an ensemble accumulated elsewhere (Chan et al.)
+  void merge(const Ensemble& other) {
+    if (other.n == 0) return;
+    double n_tot = n + other.n;
+    double wb = other.n/n_tot;
+    double wab = n*wb;
+    for (int i=0; i<ntimes(); i++) {
+      double dS = other.meanS[i] - meanS[i];
+      double dI = other.meanI[i] - meanI[i];
+      double dR = other.meanR[i] - meanR[i];
+      meanS[i] += dS*wb;
+      meanI[i] += dI*wb;
+      meanR[i] += dR*wb;
+      m2S[i] += other.m2S[i] + dS*dS*wab;
+      m2I[i] += other.m2I[i] + dI*dI*wab;
+      m2R[i] += other.m2R[i] + dR*dR*wab;
+    }
+    n += other.n;
+    inv_n = 1.0/n;
+  }
+
+  double varS(int i) const { return n > 1 ? m2S[i]/(n-1) : 0.0; }
+  double varI(int i) const { return n > 1 ? m2I[i]/(n-1) : 0.0; }
+  double varR(int i) const { return n > 1 ? m2R[i]/(n-1) : 0.0; }
+
+  // Writing time, averages and variances to file
+  void write(string filename, double dt) const {
+    ofstream outfile(filename);
+    for (int i=0; i<ntimes(); i++) {
+      outfile << setw(15) << setprecision(8) << i*dt;
+      outfile << setw(15) << setprecision(8) << meanS[i];
+      outfile << setw(15) << setprecision(8) << meanI[i];
+      outfile << setw(15) << setprecision(8) << meanR[i];
+      outfile << setw(15) << setprecision(8) << varS(i);
+      outfile << setw(15) << setprecision(8) << varI(i);
+      outfile << setw(15) << setprecision(8) << varR(i) << endl;
+    }
+  }
+
+  // Writing averages and variances as a binary trajectory file
+  void write(string filename, double dt, TrajectoryEncoding encoding) const {
+    int n_t = ntimes();
+    vector<double> vS(n_t), vI(n_t), vR(n_t);
+    for (int i=0; i<n_t; i++) {
+      vS[i] = varS(i);
+      vI[i] = varI(i);
+      vR[i] = varR(i);
+    }
+    TrajectoryWriter writer(filename, encoding);
+    writer.set_time(0.0, dt);
+    writer.add_parameter("samples", n);
+    writer.add_column("S", meanS.data(), n_t);
+    writer.add_column("I", meanI.data(), n_t);
+    writer.add_column("R", meanR.data(), n_t);
+    writer.add_column("varS", vS.data(), n_t);
+    writer.add_column("varI", vI.data(), n_t);
+    writer.add_column("varR", vR.data(), n_t);
+    if (!writer.write()) cout << "Could not write '" << filename << "'" << endl;
+  }
 };
 
+/*
+Running nsamples trajectories spread over nthreads workers. Worker w draws
+from its own Philox stream (seed, w), handles a fixed contiguous
+block of samples and accumulates into its own Ensemble. The partial
+ensembles are merged in worker order, so a given seed and thread count
+always reproduce the same output.
+sample(generator, ensemble) must call ensemble.new_sample() and then add
+every time step of one trajectory.
+*/
+template <class Sampler>
+Ensemble run_ensemble(Sampler sample, int nsamples, int ntimes,
+                      unsigned seed, int nthreads)
+{
+  if (nthreads < 1) nthreads = 1;
+  if (nthreads > nsamples) nthreads = nsamples > 0 ? nsamples : 1;
+
+  vector<Ensemble> partial(nthreads, Ensemble(ntimes));
+  vector<thread> workers;
+
+  for (int w=0; w<nthreads; w++) {
+    int first = (long) nsamples*w/nthreads;
+    int last = (long) nsamples*(w+1)/nthreads;
+    workers.push_back(thread([&, w, first, last]() {
+      Philox4x32 generator(seed, w);
+      for (int n=first; n<last; n++) sample(generator, partial[w]);
+    }));
+  }
+  for (auto& worker: workers) worker.join();
+
+  for (int w=1; w<nthreads; w++) partial[0].merge(partial[w]);
+  return partial[0];
+}
+
+// Number of reporting steps of length dt in [0, tf)
+int report_times(double dt, double tf)
+{
+  int ntimes = 0;
+  for (double t=0.0; t<tf; t+=dt) ntimes++;
+  return ntimes;
+}
+
+/*
+Averaging nsamples trajectories of a stochastic engine over nthreads
+workers and writing averages and variances to filename.dat, or to the binary
+filename.traj when format is f64, f32 or delta. The engine
+provides the reporting step dt_ and
+  sample(X, generator, ntimes, observe)
+which simulates one trajectory and calls observe(i, S, I, R) at every
+reporting step i.
+*/
+template <class Engine>
+void solve_ensemble(const Engine& engine, Population* X, string filename,
+                    int nsamples, double tf, unsigned seed, int nthreads,
+                    string format)
+{
+  int ntimes = report_times(engine.dt_, tf);
+
+  auto sampler = [&engine, X, ntimes](Philox4x32& generator,
+                                      Ensemble& ensemble) {
+    ensemble.new_sample();
+    engine.sample(X, generator, ntimes,
+                  [&ensemble](int i, double S, double I, double R) {
+                    ensemble.add(i, S, I, R);
+                  });
+  };
+
+  Ensemble ensemble = run_ensemble(sampler, nsamples, ntimes, seed, nthreads);
+
+  if (format == "txt") {
+    cout << "write to ---> " << "'" << filename+".dat'" << endl;
+    ensemble.write(filename+".dat", engine.dt_);
+  } else {
+    TrajectoryEncoding encoding = FLOAT64;
+    trajectory_encoding(format, encoding);
+    cout << "write to ---> " << "'" << filename+".traj'" << endl;
+    ensemble.write(filename+".traj", engine.dt_, encoding);
+  }
+}
+
 // Methods in this class is largely from Piazza
 class MonteCarlo
 {
@@ -63,85 +266,255 @@ public:
     if (1.0/(X->c*X->N) < dt_) dt_ = 1.0/(X->c*X->N);
   }
 
-  void solve(Population* X, string filename, int nsamples, double tf) {
+  template <class Observer>
+  void sample(Population* X, Philox4x32& generator, int ntimes,
+              Observer observe) const {
+    const int chunk = 256;      // steps per bulk draw of uniforms
+    double u[3*chunk];
+    int S = X->S[0];
+    int I = X->I[0];
+    int R = X->R[0];
 
-    mt19937 generator;
-    uniform_real_distribution<double> rand01(0.0, 1.0);
+    for (int i=0; i<ntimes; ++i) {
+      if (i % chunk == 0) generator.fill(u, 3*chunk);
+      const double* ui = u + 3*(i % chunk);
+      observe(i, S, I, R);
 
-    vector<double> time;
-    for (double t=0.0; t<tf; t+=dt_) time.push_back(t);
-    int ntimes = time.size();
+      // keep-or-reject
+      if (ui[0] < X->a*(double) S*I*dt_/X->N) {I+=1; S-=1;}
+      if (ui[1] < X->b*(double) I*dt_) {R+=1; I-=1;}
+      if (ui[2] < X->c*(double) R*dt_) {S+=1; R-=1;}
+    }
+  }
 
-    vector<double> avgS(ntimes, 0.0), avgI(ntimes, 0.0), avgR(ntimes, 0.0);
+  void solve(Population* X, string filename, int nsamples, double tf,
+             unsigned seed, int nthreads, string format = "txt") {
+    solve_ensemble(*this, X, filename, nsamples, tf, seed, nthreads, format);
+  }
+};
+
+// Exact event-driven simulation (Gillespie's direct method). The cost
+// follows the number of infection, recovery and immunity loss events,
+// while the state is reported on a fixed grid with spacing dt_.
+class Gillespie
+{
+public:
+  double dt_;
 
-    // Create random samples
-    for (int n=0; n<nsamples; ++n) {
-      ofstream outfile;
-      outfile.open(filename+to_string(n)+".dat");
-      cout << "write to ---> " << "'" << filename+to_string(n)+".dat'" << endl;
+  Gillespie(double dt) {
+    dt_ = dt;
+  }
 
-      int S = X->S[0];
-      int I = X->I[0];
-      int R = X->R[0];
+  template <class Observer>
+  void sample(Population* X, Philox4x32& generator, int ntimes,
+              Observer observe) const {
+    long S = X->S[0];
+    long I = X->I[0];
+    long R = X->R[0];
+    double t = 0.0;
+    int i = 0;
 
-      for (int i=0; i<ntimes; ++i) {
-        // Calculate averages
-        avgS[i] = S/(double) nsamples;
-        avgI[i] = I/(double) nsamples;
-        avgR[i] = R/(double) nsamples;
+    while (i < ntimes) {
+      double r_inf = X->a*(double) S*I/X->N;
+      double r_rec = X->b*(double) I;
+      double r_loss = X->c*(double) R;
+      double r_tot = r_inf + r_rec + r_loss;
 
-        // keep-or-reject
-        if (rand01(generator) < X->a*S*I*dt_/X->N) {I+=1; S-=1;}
-        if (rand01(generator) < X->b*I*dt_) {R+=1; I-=1;}
-        if (rand01(generator) < X->c*R*dt_) {S+=1; R-=1;}
+      // Time of next event, reporting every grid point passed on the way
+      double t_next = numeric_limits<double>::infinity();
+      if (r_tot > 0) t_next = t - log(1.0 - generator.uniform())/r_tot;
+      while (i < ntimes && i*dt_ < t_next) {
+        observe(i, S, I, R);
+        i++;
       }
-    }
+      if (i >= ntimes) break;
 
-    double S, I, R, N;
-    double avg_sigS = 0.0, avg_sigI = 0.0, avg_sigR = 0.0;
-    vector<double> varS(ntimes, 0.0);
-    vector<double> varI(ntimes, 0.0);
-    vector<double> varR(ntimes, 0.0);
-    int count = 0;
-
-    // Calculate variances
-    for (int n=0; n<nsamples; ++n) {
-      ifstream infile;
-      infile.open(filename + to_string(n) + ".dat");
-
-      // Calculate variance and average standard deviation
-      for (int i=0; i<ntimes; ++i) {
-        infile >> S >> I >> R >> N;
-
-        varS[i] += (avgS[i]-S)*(avgS[i]-S)/(nsamples-1);
-        varI[i] += (avgI[i]-I)*(avgI[i]-I)/(nsamples-1);
-        varR[i] += (avgR[i]-R)*(avgR[i]-R)/(nsamples-1);
-
-        avg_sigS += sqrt(varS[i])/(nsamples*ntimes);
-        avg_sigI += sqrt(varI[i])/(nsamples*ntimes);
-        avg_sigR += sqrt(varR[i])/(nsamples*ntimes);
-      }
-      infile.close();
+      // Choosing which event happens
+      double u = generator.uniform()*r_tot;
+      if (u < r_inf) {I+=1; S-=1;}
+      else if (u < r_inf + r_rec) {R+=1; I-=1;}
+      else {S+=1; R-=1;}
+      t = t_next;
     }
+  }
 
-    for (int n=0; n<nsamples; ++n) {
-      outfile.open(filename+to_string(n)+".dat");
-      for (int i=0; i<ntimes; ++i) {
-        outfile << setw(15) << setprecision(8) << varS[i];
-        outfile << setw(15) << setprecision(8) << varI[i];
-        outfile << setw(15) << setprecision(8) << varR[i] << endl;;
-        //outfile << setw(15) << setprecision(8) << avg_sigS[i];
-        //outfile << setw(15) << setprecision(8) << avg_sigI[i];
-        //outfile << setw(15) << setprecision(8) << avg_sigR[i] << endl;
+  void solve(Population* X, string filename, int nsamples, double tf,
+             unsigned seed, int nthreads, string format = "txt") {
+    solve_ensemble(*this, X, filename, nsamples, tf, seed, nthreads, format);
+  }
+};
+
+// Approximate simulation by tau-leaping: the number of events of each
+// kind during a leap tau is drawn from a Poisson distribution with the
+// rates frozen at the start of the leap. The state is reported on a
+// fixed grid with spacing dt_, which is a whole number of leaps.
+class TauLeaping
+{
+public:
+  double dt_;
+  int nleaps_;    // leaps per reporting step
+  double tau_;
+
+  TauLeaping(double dt, double tau) {
+    dt_ = dt;
+    nleaps_ = ceil(dt/tau);
+    tau_ = dt/nleaps_;
+  }
+
+  template <class Observer>
+  void sample(Population* X, Philox4x32& generator, int ntimes,
+              Observer observe) const {
+    poisson_distribution<long> events;
+    typedef poisson_distribution<long>::param_type mean;
+    long S = X->S[0];
+    long I = X->I[0];
+    long R = X->R[0];
+
+    for (int i=0; i<ntimes; ++i) {
+      observe(i, S, I, R);
+
+      for (int k=0; k<nleaps_; k++) {
+        double m_inf = X->a*(double) S*I/X->N*tau_;
+        double m_rec = X->b*(double) I*tau_;
+        double m_loss = X->c*(double) R*tau_;
+        long n_inf = m_inf > 0 ? events(generator, mean(m_inf)) : 0;
+        long n_rec = m_rec > 0 ? events(generator, mean(m_rec)) : 0;
+        long n_loss = m_loss > 0 ? events(generator, mean(m_loss)) : 0;
+
+        // No compartment may give away more people than it has
+        if (n_inf > S) n_inf = S;
+        if (n_rec > I) n_rec = I;
+        if (n_loss > R) n_loss = R;
+
+        S += n_loss - n_inf;
+        I += n_inf - n_rec;
+        R += n_rec - n_loss;
       }
     }
   }
+
+  void solve(Population* X, string filename, int nsamples, double tf,
+             unsigned seed, int nthreads, string format = "txt") {
+    solve_ensemble(*this, X, filename, nsamples, tf, seed, nthreads, format);
+  }
 };
 
+// Final state and peak of infected for one trajectory in a sweep
+struct Summary
+{
+  double S, I, R;
+  double I_max, t_max;
+};
+
+template <class Engine>
+Summary summarize(const Engine& engine, Population* X, Philox4x32& generator,
+                  double tf)
+{
+  Summary sum = {0.0, 0.0, 0.0, -1.0, 0.0};
+  double dt = engine.dt_;
+  engine.sample(X, generator, report_times(dt, tf),
+                [&sum, dt](int i, double S, double I, double R) {
+                  if (I > sum.I_max) {sum.I_max = I; sum.t_max = i*dt;}
+                  sum.S = S; sum.I = I; sum.R = R;
+                });
+  return sum;
+}
+
+/*
+Running nsamples trajectories for every scenario of the parameter grid,
+each (scenario, sample) pair being one task on a work-stealing thread
+pool, since the cost varies a lot with N and the rates. Sample n of
+scenario k draws from the Philox stream (seed, k*2^32 + n), so the
+results do not depend on the scheduling. Each task writes one line to the
+consolidated output file.
+*/
+void sweep(ParameterGrid& grid, string filename, double tf, int nsamples,
+           string method, unsigned seed, int nthreads)
+{
+  double h = 0.1;    // reporting step for gillespie and tau
+  SweepWriter writer(filename + ".dat");
+
+  ostringstream header;
+  header << "#" << setw(14) << "scenario" << setw(15) << "sample";
+  for (string name: grid.names) header << setw(15) << name;
+  header << setw(15) << "S" << setw(15) << "I" << setw(15) << "R";
+  header << setw(15) << "I_max" << setw(15) << "t_max" << endl;
+  writer.write(header.str());
+
+  ThreadPool pool(nthreads);
+  for (long k=0; k<grid.size(); k++) {
+    for (int n=0; n<nsamples; n++) {
+      pool.submit([&grid, &writer, k, n, h, tf, method, seed]() {
+        // Each worker reuses one store for all its tasks
+        static thread_local TrajectoryStore store;
+        store.reset(1, 1);
+
+        Population X;
+        X.initiate(grid.get(k, "S0"), grid.get(k, "I0"), grid.get(k, "R0"),
+                   grid.get(k, "a"), grid.get(k, "b"), grid.get(k, "c"), 1,
+                   store);
+        Philox4x32 generator(seed, ((uint64_t) k << 32) + n);
+
+        Summary sum;
+        if (method == "gillespie") {
+          sum = summarize(Gillespie(h), &X, generator, tf);
+        } else if (method == "tau") {
+          sum = summarize(TauLeaping(h, h/10), &X, generator, tf);
+        } else {
+          sum = summarize(MonteCarlo(&X), &X, generator, tf);
+        }
+
+        ostringstream line;
+        line << setw(15) << k << setw(15) << n;
+        for (string name: grid.names) line << setw(15) << grid.get(k, name);
+        line << setw(15) << sum.S << setw(15) << sum.I << setw(15) << sum.R;
+        line << setw(15) << sum.I_max << setw(15) << sum.t_max << endl;
+        writer.write(line.str());
+
+      });
+    }
+  }
+  pool.wait();
+}
+
+/*
+Sweeping the parameter grid for equilibria of the mean-field rates only,
+with no sampling. Each line has the scenario number, the parameter
+values, S, I and R of the long-run equilibrium, the reproduction number
+and whether the equilibrium is stable (0), unstable (1) or marginal (2).
+*/
+void sweep_steady(ParameterGrid& grid, string filename)
+{
+  SweepWriter writer(filename + ".dat");
+
+  ostringstream header;
+  header << "#" << setw(14) << "scenario";
+  for (string name: grid.names) header << setw(15) << name;
+  header << setw(15) << "S" << setw(15) << "I" << setw(15) << "R";
+  header << setw(15) << "R_0" << setw(15) << "stability" << endl;
+  writer.write(header.str());
+
+  for (long k=0; k<grid.size(); k++) {
+    SIRSParameters p = {grid.get(k, "S0") + grid.get(k, "I0") + grid.get(k, "R0"),
+                        grid.get(k, "a"), grid.get(k, "b"), grid.get(k, "c"),
+                        0.0, 0.0, 0.0, 0.0};
+    Equilibrium eq = long_run(p);
+
+    ostringstream line;
+    line << setw(15) << k;
+    for (string name: grid.names) line << setw(15) << grid.get(k, name);
+    line << setw(15) << eq.S << setw(15) << eq.I << setw(15) << eq.R;
+    line << setw(15) << p.reproduction_number(disease_free(p).S);
+    line << setw(15) << eq.stability << endl;
+    writer.write(line.str());
+  }
+}
+
 
 int main(int argc, char* argv[])
 {
-  // Reading output filename from command line
+  // Reading output filename, number of threads, method (mc, gillespie or
+  // tau) and output format (txt, f64, f32 or delta) from command line
   ofstream ofile;
   string filename;
   if (argc<=1) {
@@ -150,6 +523,73 @@ int main(int argc, char* argv[])
   } else {
     filename = argv[1];
   }
+  unsigned seed = 2020;   // fixed seed for reproducible ensembles
+
+  /*
+  Parameter sweep: ./main_mc.x filename sweep [option=value ...]
+  [name=lo:hi:n ...] where the options are method (mc, gillespie, tau or
+  steady, the last finding the equilibria of the mean-field rates without
+  sampling), days, samples and threads, and the parameters are S0, I0, R0,
+  a, b and c
+  */
+  if (argc>2 && string(argv[2]) == "sweep") {
+    ParameterGrid grid;
+    grid.set("S0", 300); grid.set("I0", 100); grid.set("R0", 0);
+    grid.set("a", 4); grid.set("b", 1); grid.set("c", 0.5);
+    string method = "gillespie";
+    double days = 15;
+    int nsamples = 100;
+    int nthreads = thread::hardware_concurrency();
+
+    for (int k=3; k<argc; k++) {
+      string arg = argv[k];
+      if (arg.compare(0, 7, "method=") == 0) method = arg.substr(7);
+      else if (arg.compare(0, 5, "days=") == 0) days = atof(arg.c_str() + 5);
+      else if (arg.compare(0, 8, "samples=") == 0) nsamples = atoi(arg.c_str() + 8);
+      else if (arg.compare(0, 8, "threads=") == 0) nthreads = atoi(arg.c_str() + 8);
+      else if (!grid.parse(arg)) {
+        cout << "Could not read parameter '" << arg << "', the parameters are";
+        for (string name: grid.names) cout << " " << name;
+        cout << endl;
+        return 1;
+      }
+    }
+    if (method != "mc" && method != "gillespie" && method != "tau"
+        && method != "steady") {
+      cout << "Unknown method '" << method
+           << "', use mc, gillespie, tau or steady" << endl;
+      return 1;
+    }
+    if (method == "steady") {
+      cout << "Sweeping " << grid.size() << " scenarios ---> '" << filename
+           << ".dat'" << endl;
+      sweep_steady(grid, filename);
+      return 0;
+    }
+    cout << "Sweeping " << grid.size() << " scenarios x " << nsamples
+         << " samples ---> '" << filename << ".dat'" << endl;
+    sweep(grid, filename, days, nsamples, method, seed, nthreads);
+    return 0;
+  }
+
+  int nthreads = thread::hardware_concurrency();
+  if (argc>2) nthreads = atoi(argv[2]);
+  if (nthreads < 1) nthreads = 1;
+  string method = "mc";
+  if (argc>3) method = argv[3];
+  if (method != "mc" && method != "gillespie" && method != "tau") {
+    cout << "Unknown method '" << method << "', use mc, gillespie or tau"
+         << endl;
+    return 1;
+  }
+  string format = "txt";
+  if (argc>4) format = argv[4];
+  TrajectoryEncoding encoding = FLOAT64;
+  if (format != "txt" && !trajectory_encoding(format, encoding)) {
+    cout << "Unknown format '" << format << "', use txt, f64, f32 or delta"
+         << endl;
+    return 1;
+  }
 
   // Defining time parameters
   int days = 15;          // days of simulation time
@@ -157,21 +597,42 @@ int main(int argc, char* argv[])
   int steps = days/h;     // number of iterations for RK4-method
 
   // Setting up the different populations
-  Population A; A.initiate(300, 100, 0, 4, 1, 0.5, steps);
-  Population B; B.initiate(300, 100, 0, 4, 2, 0.5, steps);
-  Population C; C.initiate(300, 100, 0, 4, 3, 0.5, steps);
-  Population D; D.initiate(300, 100, 0, 4, 4, 0.5, steps);
-  Population pops[] = {A, B, C, D};
+  TrajectoryStore store;
+  store.reset(4, steps);
+  Population pops[4];
+  pops[0].initiate(300, 100, 0, 4, 1, 0.5, steps, store);
+  pops[1].initiate(300, 100, 0, 4, 2, 0.5, steps, store);
+  pops[2].initiate(300, 100, 0, 4, 3, 0.5, steps, store);
+  pops[3].initiate(300, 100, 0, 4, 4, 0.5, steps, store);
+
+  char filename_ending[] = {"ABCD"};
+
+  // Equilibria of the mean-field rates only: ./main_mc.x filename steady
+  if (argc>2 && string(argv[2]) == "steady") {
+    for (int x=0; x<4; x++) {
+      cout << filename_ending[x] << ": ";
+      print_equilibria(cout, pops[x].parameters());
+    }
+    return 0;
+  }
 
   int nsamples;
   cout << "Provide number of samples:" << endl;
   cin >> nsamples;
 
-  char filename_ending[] = {"ABCD"};
   // Iterating over the populations
   for (int x=0; x<4; x++) {
-    MonteCarlo solver(&pops[x]);
-    solver.solve(&pops[x], filename+filename_ending[x]+"_", nsamples, days);
+    string outfile = filename + filename_ending[x];
+    if (method == "gillespie") {
+      Gillespie solver(h);
+      solver.solve(&pops[x], outfile, nsamples, days, seed, nthreads, format);
+    } else if (method == "tau") {
+      TauLeaping solver(h, h/10);
+      solver.solve(&pops[x], outfile, nsamples, days, seed, nthreads, format);
+    } else {
+      MonteCarlo solver(&pops[x]);
+      solver.solve(&pops[x], outfile, nsamples, days, seed, nthreads, format);
+    }
     /*
     // Print results to output file
     string outfile = filename + filename_ending[x] + ".dat";
@@ -3,6 +3,17 @@
 #include <fstream>
 #include <iomanip>
 #include <cmath>
+#include <vector>
+#include <sstream>
+#include <thread>
+#include "rk4.h"
+#include "rk45.h"
+#include "rk4_batch.h"
+#include "steady_state.h"
+#include "thread_pool.h"
+#include "sweep.h"
+#include "trajectory.h"
+#include "trajectory_store.h"
 
 using namespace std;
 
@@ -15,22 +26,32 @@ public:
   double* R;  // recovered array
   //int a;      // rate of transmission
   //int b;      // rate of recovery
-  int b;      // birth rate
+  double b;   // birth rate
   float c;    // rate of immunity loss
   float d;    // death rate
   float dI;   // death rate of infected people due to disease
   float e;    // susceptibility rate, e.g. all newborns
-  float f;    // vaccination
+  float f;    // vaccination rate, moving susceptible directly to recovered
+  double a0;  // mean rate of transmission
 
   Population() {
+    S = I = R = nullptr;
   }
 
+  // The arrays belong to a TrajectoryStore, so populations are moved,
+  // never copied
+  Population(const Population&) = delete;
+  Population& operator=(const Population&) = delete;
+  Population(Population&&) = default;
+  Population& operator=(Population&&) = default;
+
   ~Population() {}
 
-  void initiate(double S0, double I0, double R0, int birth_rate, float imloss_rate, float death_rate, float death_inf_rate, int steps) {
-    S = new double[steps]; S[0] = S0;
-    I = new double[steps]; I[0] = I0;
-    R = new double[steps]; R[0] = R0;
+  void initiate(double S0, double I0, double R0, double birth_rate, float imloss_rate, float death_rate, float death_inf_rate, int steps, TrajectoryStore& store) {
+    double* block = store.take(3*(size_t) steps);
+    S = block;           S[0] = S0;
+    I = block + steps;   I[0] = I0;
+    R = block + 2*steps; R[0] = R0;
     N = S[0] + I[0] + R[0];
     //b = recov_rate;
     b = birth_rate;
@@ -38,30 +59,54 @@ public:
     d = death_rate;
     dI = death_inf_rate;
     e = birth_rate;
+    f = 0.0;
+    a0 = 4.0;
   }
 
   double a(double t) {
     // Seasonal variation of a
-    return 1.0*cos(0.05*t) + 4.0;
+    return 1.0*cos(0.05*t) + a0;
   }
 
   double dSdt(double t, double s, double i, double r) {
-    return c*r - (a(t)*s*i)/N - d*s + e*N;
+    return c*r - (a(t)*s*i)/N - d*s + e*N - f*s;
   }
 
   double dIdt(double t, double s, double i) {
     return (a(t)*s*i)/N - b*i - d*i - dI*i;
   }
 
-  double dRdt(double i, double r) {
-    return b*i - c*r - d*i;
+  double dRdt(double s, double i, double r) {
+    return b*i - c*r - d*i + f*s;
+  }
+
+  // The rates for steady_state.h, with the transmission rate at its mean
+  // a0 since the seasonal term averages out over a period
+  SIRSParameters parameters() const {
+    SIRSParameters p = {(double) N, a0, b, c, d, dI, e, f};
+    return p;
+  }
+};
+
+// Right-hand side of the SIRS equations for the steppers in rk4.h
+struct SIRS
+{
+  Population* X;
+
+  void operator()(double t, const double* y, double* dydt) const {
+    dydt[0] = X->dSdt(t, y[0], y[1], y[2]);
+    dydt[1] = X->dIdt(t, y[0], y[1]);
+    dydt[2] = X->dRdt(y[0], y[1], y[2]);
   }
 };
 
 class RungeKutta4
 {
 public:
+  long nfev;    // derivative evaluations in last integration
+
   RungeKutta4() {
+    nfev = 0;
   }
 
   void integrate(Population* X, double h, int steps) {
@@ -72,36 +117,177 @@ public:
     double* S = X->S;
     double* I = X->I;
     double* R = X->R;
+    SIRS derivs = {X};
 
     for (int i=0; i<steps-1; i++) {
-      double s_k1 = h*X->dSdt(i*h, S[i], I[i], R[i]);
-      double i_k1 = h*X->dIdt(i*h, S[i], I[i]);
-      double r_k1 = h*X->dRdt(I[i], R[i]);
+      double y[3] = {S[i], I[i], R[i]};
+      rk4_step<3>(y, i*h, h, derivs);
+
+      S[i+1] = y[0];
+      I[i+1] = y[1];
+      R[i+1] = y[2];
+      //R[i+1] = X->N - S[i+1] - I[i+1];
+    }
+    nfev = 4L*(steps-1);
+  }
+};
+
+class RungeKutta45
+{
+public:
+  double rtol;
+  double atol;
+  long nfev;    // derivative evaluations in last integration
 
-      double s_k2 = h*X->dSdt(i*h + h/2, S[i] + s_k1/2, I[i] + s_k1/2, R[i] + s_k1/2);
-      double i_k2 = h*X->dIdt(i*h + h/2, S[i] + i_k1/2, I[i] + i_k1/2);
-      double r_k2 = h*X->dRdt(I[i] + r_k1/2, R[i] + r_k1/2);
+  RungeKutta45(double rel_tol, double abs_tol) {
+    rtol = rel_tol;
+    atol = abs_tol;
+    nfev = 0;
+  }
 
-      double s_k3 = h*X->dSdt(i*h + h/2, S[i] + s_k2/2, I[i] + s_k2/2, R[i] + s_k2/2);
-      double i_k3 = h*X->dIdt(i*h + h/2, S[i] + i_k2/2, I[i] + i_k2/2);
-      double r_k3 = h*X->dRdt(I[i] + r_k2/2, R[i] + r_k2/2);
+  void integrate(Population* X, double h, int steps) {
+    /*
+    Integrate with adaptive Dormand-Prince steps and sample the
+    solution at the fixed report times i*h from the dense output
+    */
+    SIRS derivs = {X};
+    RK45<3, SIRS> solver(derivs, rtol, atol);
 
-      double s_k4 = h*X->dSdt(i*h + h, S[i] + s_k3, I[i] + s_k3, R[i] + s_k3);
-      double i_k4 = h*X->dIdt(i*h + h, S[i] + i_k3, I[i] + i_k3);
-      double r_k4 = h*X->dRdt(I[i] + r_k3, R[i] + r_k3);
+    vector<double> tout(steps);
+    for (int i=0; i<steps; i++) tout[i] = i*h;
 
-      S[i+1] = S[i] + (s_k1 + 2*s_k2 + 2*s_k3 + s_k4)/6;
-      I[i+1] = I[i] + (i_k1 + 2*i_k2 + 2*i_k3 + i_k4)/6;
-      R[i+1] = R[i] + (r_k1 + 2*r_k2 + 2*r_k3 + r_k4)/6;
-      //R[i+1] = X->N - S[i+1] - I[i+1];
+    double y[3] = {X->S[0], X->I[0], X->R[0]};
+    auto report = [X](int i, double /*t*/, const double* yi) {
+      X->S[i] = yi[0];
+      X->I[i] = yi[1];
+      X->R[i] = yi[2];
+    };
+    if (solver.integrate(y, 0.0, tout.data(), steps, report) != 0) {
+      cout << "RungeKutta45: step size underflow" << endl;
     }
+    nfev = solver.nfev;
   }
 };
 
+// Writing S, I, R and N of a population to a binary trajectory file
+void write_trajectory(Population& X, string filename, double h, int steps,
+                      TrajectoryEncoding encoding)
+{
+  vector<double> N(steps);
+  for (int i=0; i<steps; i++) N[i] = X.S[i] + X.I[i] + X.R[i];
+
+  TrajectoryWriter writer(filename, encoding);
+  writer.set_time(0.0, h);
+  writer.add_parameter("a0", X.a0);
+  writer.add_parameter("b", X.b);
+  writer.add_parameter("c", X.c);
+  writer.add_parameter("d", X.d);
+  writer.add_parameter("dI", X.dI);
+  writer.add_parameter("e", X.e);
+  writer.add_parameter("f", X.f);
+  writer.add_column("S", X.S, steps);
+  writer.add_column("I", X.I, steps);
+  writer.add_column("R", X.R, steps);
+  writer.add_column("N", N.data(), steps);
+  if (!writer.write()) cout << "Could not write '" << filename << "'" << endl;
+}
+
+/*
+Integrating every scenario of the parameter grid as one task on a
+work-stealing thread pool. Each task writes one line to the consolidated
+output file: scenario number, parameter values, final S, I and R and the
+peak of I with the time it occurs.
+*/
+void sweep(ParameterGrid& grid, string filename, int days, double h,
+           string method, int nthreads)
+{
+  int steps = days/h;
+  SweepWriter writer(filename + ".dat");
+
+  ostringstream header;
+  header << "#" << setw(14) << "scenario";
+  for (string name: grid.names) header << setw(15) << name;
+  header << setw(15) << "S" << setw(15) << "I" << setw(15) << "R";
+  header << setw(15) << "I_max" << setw(15) << "t_max" << endl;
+  writer.write(header.str());
+
+  ThreadPool pool(nthreads);
+  for (long k=0; k<grid.size(); k++) {
+    pool.submit([&grid, &writer, k, h, steps, method]() {
+      // Each worker reuses one store for all its scenarios
+      static thread_local TrajectoryStore store;
+      store.reset(1, steps);
+
+      Population X;
+      X.initiate(grid.get(k, "S0"), grid.get(k, "I0"), grid.get(k, "R0"),
+                 grid.get(k, "b"), grid.get(k, "c"), grid.get(k, "d"),
+                 grid.get(k, "dI"), steps, store);
+      X.a0 = grid.get(k, "a0");
+      X.f = grid.get(k, "f");
+
+      if (method == "rk45") {
+        RungeKutta45 integrator(1e-6, 1e-6);
+        integrator.integrate(&X, h, steps);
+      } else {
+        RungeKutta4 integrator;
+        integrator.integrate(&X, h, steps);
+      }
+
+      int imax = 0;
+      for (int i=1; i<steps; i++) if (X.I[i] > X.I[imax]) imax = i;
+
+      ostringstream line;
+      line << setw(15) << k;
+      for (string name: grid.names) line << setw(15) << grid.get(k, name);
+      line << setw(15) << X.S[steps-1] << setw(15) << X.I[steps-1];
+      line << setw(15) << X.R[steps-1];
+      line << setw(15) << X.I[imax] << setw(15) << imax*h << endl;
+      writer.write(line.str());
+
+    });
+  }
+  pool.wait();
+}
+
+/*
+Sweeping the parameter grid for equilibria only, with no integration in
+time. Each line has the scenario number, the parameter values, S, I and R
+of the long-run equilibrium, the reproduction number and whether the
+equilibrium is stable (0), unstable (1) or marginal (2).
+*/
+void sweep_steady(ParameterGrid& grid, string filename)
+{
+  SweepWriter writer(filename + ".dat");
+
+  ostringstream header;
+  header << "#" << setw(14) << "scenario";
+  for (string name: grid.names) header << setw(15) << name;
+  header << setw(15) << "S" << setw(15) << "I" << setw(15) << "R";
+  header << setw(15) << "R_0" << setw(15) << "stability" << endl;
+  writer.write(header.str());
+
+  for (long k=0; k<grid.size(); k++) {
+    SIRSParameters p = {grid.get(k, "S0") + grid.get(k, "I0") + grid.get(k, "R0"),
+                        grid.get(k, "a0"), grid.get(k, "b"), grid.get(k, "c"),
+                        grid.get(k, "d"), grid.get(k, "dI"), grid.get(k, "b"),
+                        grid.get(k, "f")};
+    Equilibrium eq = long_run(p);
+
+    ostringstream line;
+    line << setw(15) << k;
+    for (string name: grid.names) line << setw(15) << grid.get(k, name);
+    line << setw(15) << eq.S << setw(15) << eq.I << setw(15) << eq.R;
+    line << setw(15) << p.reproduction_number(disease_free(p).S);
+    line << setw(15) << eq.stability << endl;
+    writer.write(line.str());
+  }
+}
+
 
 int main(int argc, char* argv[])
 {
-  // Reading output filename from command line
+  // Reading output filename, method (rk4, rk45, batch or steady), number of days
+  // and output format (txt, f64, f32 or delta) from command line
   ofstream ofile;
   string filename;
   if (argc<=1) {
@@ -110,25 +296,128 @@ int main(int argc, char* argv[])
   } else {
     filename = argv[1];
   }
+  string method = "rk4";
+  if (argc>2) method = argv[2];
+
+  /*
+  Parameter sweep: ./main_rk4.x filename sweep [option=value ...]
+  [name=lo:hi:n ...] where the options are method (rk4, rk45 or steady,
+  the last finding equilibria without integrating), days and threads, and
+  the parameters are S0, I0, R0, a0, b, c, d, dI and f
+  */
+  if (method == "sweep") {
+    ParameterGrid grid;
+    grid.set("S0", 300); grid.set("I0", 100); grid.set("R0", 0);
+    grid.set("a0", 4.0); grid.set("b", 1); grid.set("c", 0.5);
+    grid.set("d", 0.6); grid.set("dI", 1.0); grid.set("f", 0.0);
+    string sweep_method = "rk4";
+    int days = 365;
+    int nthreads = thread::hardware_concurrency();
+
+    for (int k=3; k<argc; k++) {
+      string arg = argv[k];
+      if (arg.compare(0, 7, "method=") == 0) sweep_method = arg.substr(7);
+      else if (arg.compare(0, 5, "days=") == 0) days = atoi(arg.c_str() + 5);
+      else if (arg.compare(0, 8, "threads=") == 0) nthreads = atoi(arg.c_str() + 8);
+      else if (!grid.parse(arg)) {
+        cout << "Could not read parameter '" << arg << "', the parameters are";
+        for (string name: grid.names) cout << " " << name;
+        cout << endl;
+        return 1;
+      }
+    }
+    if (sweep_method != "rk4" && sweep_method != "rk45"
+        && sweep_method != "steady") {
+      cout << "Unknown method '" << sweep_method << "', use rk4, rk45 or steady"
+           << endl;
+      return 1;
+    }
+    cout << "Sweeping " << grid.size() << " scenarios ---> '"
+         << filename << ".dat'" << endl;
+    if (sweep_method == "steady") sweep_steady(grid, filename);
+    else sweep(grid, filename, days, 0.1, sweep_method, nthreads);
+    return 0;
+  }
+  if (method != "rk4" && method != "rk45" && method != "batch"
+      && method != "steady") {
+    cout << "Unknown method '" << method
+         << "', use rk4, rk45, batch, steady or sweep" << endl;
+    return 1;
+  }
 
   // Defining time parameters
   int days = 365;          // days of simulation time
+  if (argc>3) days = atoi(argv[3]);
+  string format = "txt";
+  if (argc>4) format = argv[4];
+  TrajectoryEncoding encoding = FLOAT64;
+  if (format != "txt" && !trajectory_encoding(format, encoding)) {
+    cout << "Unknown format '" << format << "', use txt, f64, f32 or delta"
+         << endl;
+    return 1;
+  }
   double h = 0.1;         // Step size in days
   int steps = days/h;     // number of iterations for RK4-method
 
   // Setting up the different populations
-  Population A; A.initiate(300, 100, 0, 1, 0.5, 0.6, 1.0, steps);
-  Population B; B.initiate(300, 100, 0, 2, 0.5, 0.8, 1.3, steps);
-  Population C; C.initiate(300, 100, 0, 3, 0.5, 1.0, 1.6, steps);
-  Population D; D.initiate(300, 100, 0, 4, 0.5, 1.2, 1.9, steps);
-  Population pops[] = {A, B, C, D};
+  TrajectoryStore store;
+  store.reset(4, steps);
+  Population pops[4];
+  pops[0].initiate(300, 100, 0, 1, 0.5, 0.6, 1.0, steps, store);
+  pops[1].initiate(300, 100, 0, 2, 0.5, 0.8, 1.3, steps, store);
+  pops[2].initiate(300, 100, 0, 3, 0.5, 1.0, 1.6, steps, store);
+  pops[3].initiate(300, 100, 0, 4, 0.5, 1.2, 1.9, steps, store);
+
+  char filename_ending[] = {"ABCD"};
+
+  // Equilibria only: ./main_rk4.x filename steady
+  if (method == "steady") {
+    for (int x=0; x<4; x++) {
+      cout << filename_ending[x] << ": ";
+      print_equilibria(cout, pops[x].parameters());
+    }
+    return 0;
+  }
 
   RungeKutta4 integrator;
+  RungeKutta45 adaptive(1e-6, 1e-6);
+
+  // Integrating all populations together in one batch
+  if (method == "batch") {
+    SIRSBatch batch;
+    for (int x=0; x<4; x++) {
+      batch.add(pops[x].S[0], pops[x].I[0], pops[x].R[0], pops[x].b,
+                pops[x].c, pops[x].d, pops[x].dI);
+    }
+    batch.integrate(h, steps, [&](int i) {
+      for (int x=0; x<4; x++) {
+        pops[x].S[i] = batch.S[x];
+        pops[x].I[i] = batch.I[x];
+        pops[x].R[i] = batch.R[x];
+      }
+    });
+  }
 
-  char filename_ending[] = {"ABCD"};
   // Iterating over the populations
   for (int x=0; x<4; x++) {
-    integrator.integrate(&pops[x], h, steps);
+    long nfev = 0;
+    if (method == "batch") {
+      nfev = 4L*(steps-1);
+    } else if (method == "rk45") {
+      adaptive.integrate(&pops[x], h, steps);
+      nfev = adaptive.nfev;
+    } else {
+      integrator.integrate(&pops[x], h, steps);
+      nfev = integrator.nfev;
+    }
+    cout << filename_ending[x] << ": " << nfev << " derivative evaluations" << endl;
+
+    // Binary trajectory, convert to text with traj2txt.x
+    if (format != "txt") {
+      write_trajectory(pops[x], filename + filename_ending[x] + ".traj", h,
+                       steps, encoding);
+      continue;
+    }
 
     // Print results to output file
     string outfile = filename + filename_ending[x] + ".dat";
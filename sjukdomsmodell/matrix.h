@@ -0,0 +1,198 @@
+    /*
+     * The definition module
+     *                      matrix.h
+     * for dense matrices of doubles. Matrix owns its elements in one
+     * 64-byte aligned block with 64-bit sizes and is freed when it goes
+     * out of scope. MatrixView refers to elements owned elsewhere through
+     * a row and a column stride, so submatrices and transposes are views
+     * without copies. RowPointers adapts a view with unit column stride
+     * to the double** interface of the routines in lib.cpp, again without
+     * copying the elements.
+     */
+
+#ifndef MATRIX_H
+#define MATRIX_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+class MatrixView
+{
+public:
+  MatrixView() : data_(0), rows_(0), cols_(0), rs_(0), cs_(1) {
+  }
+
+  MatrixView(double* data, size_t rows, size_t cols, ptrdiff_t row_stride,
+             ptrdiff_t col_stride = 1)
+    : data_(data), rows_(rows), cols_(cols), rs_(row_stride),
+      cs_(col_stride) {
+  }
+
+  double& operator()(size_t i, size_t j) const {
+    return data_[(ptrdiff_t) i*rs_ + (ptrdiff_t) j*cs_];
+  }
+
+  size_t rows() const { return rows_; }
+  size_t cols() const { return cols_; }
+  ptrdiff_t row_stride() const { return rs_; }
+  ptrdiff_t col_stride() const { return cs_; }
+  double* data() const { return data_; }
+
+  // Start of row i; the row is contiguous if col_stride() is 1
+  double* row(size_t i) const {
+    return data_ + (ptrdiff_t) i*rs_;
+  }
+
+  // The nrows x ncols submatrix starting at element (i, j)
+  MatrixView block(size_t i, size_t j, size_t nrows, size_t ncols) const {
+    return MatrixView(&(*this)(i, j), nrows, ncols, rs_, cs_);
+  }
+
+  MatrixView transpose() const {
+    return MatrixView(data_, cols_, rows_, cs_, rs_);
+  }
+
+  // Whether the elements are stored row by row with no gaps, as the
+  // contiguous routines in lib.cpp, e.g. ludcmp(double*, ...), expect
+  bool contiguous() const {
+    return cs_ == 1 && (rs_ == (ptrdiff_t) cols_ || rows_ <= 1);
+  }
+
+  // Copying the elements of another view of the same shape
+  void assign(const MatrixView& other) const {
+    for (size_t i=0; i<rows_; i++) {
+      for (size_t j=0; j<cols_; j++) (*this)(i, j) = other(i, j);
+    }
+  }
+
+private:
+  double* data_;
+  size_t rows_, cols_;
+  ptrdiff_t rs_, cs_;
+};
+
+class Matrix
+{
+public:
+  static const size_t alignment = 64;
+
+  Matrix() : data_(0), rows_(0), cols_(0), stride_(0) {
+  }
+
+  /*
+  A rows x cols matrix set to zero. The rows are row_stride elements
+  apart, cols if row_stride is 0; padded_stride(cols) makes every row
+  start on a 64-byte boundary. Throws std::bad_alloc on failure.
+  */
+  Matrix(size_t rows, size_t cols, size_t row_stride = 0)
+    : data_(0), rows_(rows), cols_(cols),
+      stride_(row_stride ? row_stride : cols) {
+    size_t n = rows_*stride_;
+    if (stride_ != 0 && n/stride_ != rows_) throw std::bad_alloc();
+    if (n > ((size_t) -1)/sizeof(double)) throw std::bad_alloc();
+    void* p = 0;
+    if (posix_memalign(&p, alignment, n ? n*sizeof(double) : alignment) != 0) {
+      throw std::bad_alloc();
+    }
+    data_ = (double*) p;
+    memset(data_, 0, n*sizeof(double));
+  }
+
+  ~Matrix() {
+    free(data_);
+  }
+
+  Matrix(const Matrix&) = delete;
+  Matrix& operator=(const Matrix&) = delete;
+
+  Matrix(Matrix&& other)
+    : data_(other.data_), rows_(other.rows_), cols_(other.cols_),
+      stride_(other.stride_) {
+    other.data_ = 0;
+    other.rows_ = other.cols_ = other.stride_ = 0;
+  }
+
+  Matrix& operator=(Matrix&& other) {
+    if (this != &other) {
+      free(data_);
+      data_ = other.data_;
+      rows_ = other.rows_;
+      cols_ = other.cols_;
+      stride_ = other.stride_;
+      other.data_ = 0;
+      other.rows_ = other.cols_ = other.stride_ = 0;
+    }
+    return *this;
+  }
+
+  // Smallest row stride of at least cols elements keeping rows aligned
+  static size_t padded_stride(size_t cols) {
+    size_t k = alignment/sizeof(double);
+    return (cols + k - 1)/k*k;
+  }
+
+  double& operator()(size_t i, size_t j) {
+    return data_[i*stride_ + j];
+  }
+
+  double operator()(size_t i, size_t j) const {
+    return data_[i*stride_ + j];
+  }
+
+  size_t rows() const { return rows_; }
+  size_t cols() const { return cols_; }
+  size_t row_stride() const { return stride_; }
+  double* data() { return data_; }
+  const double* data() const { return data_; }
+  double* row(size_t i) { return data_ + i*stride_; }
+
+  MatrixView view() {
+    return MatrixView(data_, rows_, cols_, stride_);
+  }
+
+  operator MatrixView() {
+    return view();
+  }
+
+  MatrixView block(size_t i, size_t j, size_t nrows, size_t ncols) {
+    return view().block(i, j, nrows, ncols);
+  }
+
+private:
+  double* data_;
+  size_t rows_, cols_, stride_;
+};
+
+/*
+Row pointers into a view with unit column stride, for the double**
+routines in lib.cpp, e.g.
+  Matrix a(n, n);
+  RowPointers rows(a);
+  ludcmp(rows, n, indx, &d);
+Only the n pointers are allocated; the elements are those of the view,
+which must outlive the RowPointers. A view whose rows are not contiguous,
+e.g. a transpose, throws std::invalid_argument.
+*/
+class RowPointers
+{
+public:
+  RowPointers(const MatrixView& m) : rows_(m.rows()) {
+    if (m.col_stride() != 1 && m.cols() > 1) {
+      throw std::invalid_argument("RowPointers: column stride is not 1");
+    }
+    for (size_t i=0; i<m.rows(); i++) rows_[i] = m.row(i);
+  }
+
+  operator double**() {
+    return rows_.empty() ? 0 : &rows_[0];
+  }
+
+private:
+  std::vector<double*> rows_;
+};
+
+#endif
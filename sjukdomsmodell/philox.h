@@ -0,0 +1,131 @@
+    /*
+     * The definition module
+     *                      philox.h
+     * for the counter-based random number generator Philox4x32-10 of
+     * Salmon et al., "Parallel random numbers: as easy as 1, 2, 3" (SC11).
+     * The n'th block of four 32-bit numbers is a pure function of the key
+     * (from the seed) and the 128-bit counter (stream number, n), so
+     *  - all state is in the object, unlike ran0()-ran3() in lib.cpp,
+     *  - independent streams are obtained by choosing another stream
+     *    number, and skipping ahead any distance costs O(1),
+     *  - bulk generation has no dependency between blocks and vectorizes.
+     * The class meets the requirements of a uniform random bit generator,
+     * so it can also drive the distributions in <random>.
+     */
+
+#ifndef PHILOX_H
+#define PHILOX_H
+
+#include <cstddef>
+#include <cstdint>
+
+class Philox4x32
+{
+public:
+  typedef uint32_t result_type;
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return 0xFFFFFFFFu; }
+
+  Philox4x32(uint64_t seed = 0, uint64_t stream = 0) {
+    key_[0] = (uint32_t) seed;
+    key_[1] = (uint32_t) (seed >> 32);
+    stream_ = stream;
+    block_ = 0;
+    pos_ = 4;
+  }
+
+  // Generator for another, independent stream with the same seed
+  Philox4x32 split(uint64_t stream) const {
+    Philox4x32 g;
+    g.key_[0] = key_[0];
+    g.key_[1] = key_[1];
+    g.stream_ = stream;
+    return g;
+  }
+
+  result_type operator()() {
+    if (pos_ == 4) {
+      generate(block_++, out_);
+      pos_ = 0;
+    }
+    return out_[pos_++];
+  }
+
+  // Skipping the next n numbers in O(1)
+  void discard(uint64_t n) {
+    uint64_t left = 4 - pos_;
+    if (n < left) {
+      pos_ += n;
+      return;
+    }
+    n -= left;
+    block_ += n/4;
+    pos_ = 4;
+    if (n % 4) {
+      generate(block_++, out_);
+      pos_ = n % 4;
+    }
+  }
+
+  // Uniform deviate in [0, 1) with 53 random bits
+  double uniform() {
+    uint64_t hi = (*this)();
+    uint64_t lo = (*this)();
+    return to_double(hi, lo);
+  }
+
+  /*
+  Filling x[0..n-1] with uniform deviates in [0, 1). Whole blocks are
+  generated directly into the output, two deviates per block, and the
+  loop has no dependency between iterations.
+  */
+  void fill(double* x, size_t n) {
+    size_t i = 0;
+    while (i < n && pos_ < 4) x[i++] = uniform();
+    size_t nblocks = (n - i)/2;
+    uint64_t first = block_;
+    for (size_t k=0; k<nblocks; k++) {
+      uint32_t r[4];
+      generate(first + k, r);
+      x[i + 2*k]     = to_double(r[0], r[1]);
+      x[i + 2*k + 1] = to_double(r[2], r[3]);
+    }
+    block_ += nblocks;
+    i += 2*nblocks;
+    if (i < n) x[i] = uniform();
+  }
+
+  // The four numbers of block n of this stream
+  void generate(uint64_t n, uint32_t* r) const {
+    uint32_t c0 = (uint32_t) n, c1 = (uint32_t) (n >> 32);
+    uint32_t c2 = (uint32_t) stream_, c3 = (uint32_t) (stream_ >> 32);
+    uint32_t k0 = key_[0], k1 = key_[1];
+    for (int round=0; round<10; round++) {
+      uint64_t p0 = (uint64_t) 0xD2511F53u*c0;
+      uint64_t p1 = (uint64_t) 0xCD9E8D57u*c2;
+      uint32_t t0 = (uint32_t) (p1 >> 32) ^ c1 ^ k0;
+      uint32_t t2 = (uint32_t) (p0 >> 32) ^ c3 ^ k1;
+      c1 = (uint32_t) p1;
+      c3 = (uint32_t) p0;
+      c0 = t0;
+      c2 = t2;
+      k0 += 0x9E3779B9u;
+      k1 += 0xBB67AE85u;
+    }
+    r[0] = c0; r[1] = c1; r[2] = c2; r[3] = c3;
+  }
+
+private:
+  uint32_t key_[2];
+  uint64_t stream_;
+  uint64_t block_;      // next block to generate
+  int pos_;             // numbers used from out_, 4 when empty
+  uint32_t out_[4];
+
+  static double to_double(uint64_t hi, uint64_t lo) {
+    return ((hi << 21) ^ (lo >> 11))*(1.0/9007199254740992.0);
+  }
+};
+
+#endif
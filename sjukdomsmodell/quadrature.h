@@ -0,0 +1,277 @@
+    /*
+     * The definition module
+     *                      quadrature.h
+     * for Gauss-Legendre quadrature with cached rules. The abcissas and
+     * weights on [-1, 1] come from gauleg_table() in lib.cpp, which
+     * computes them once per number of points; an interval [a, b] is then
+     * only an affine map of the nodes, folded into the sum. Many integrals
+     * can be done in one batch, where the integrand is called on whole
+     * arrays of points so that it can be vectorized.
+     *
+     * Also the trapezoidal and midpoint rules on n intervals and Romberg
+     * integration, as templates over the integrand. The integrand is
+     * either a function object f(x), which the compiler can inline, or
+     * an array callback f(x, y, count) setting y[i] = f(x[i]) (the
+     * _batch versions). The points are evaluated in blocks, each block
+     * is summed pairwise, and the block sums are added with compensated
+     * summation, optionally spread over threads.
+     */
+
+#ifndef QUADRATURE_H
+#define QUADRATURE_H
+
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "lib.h"
+
+class GaussLegendre
+{
+public:
+  // The n-point rule; cheap once the table for n exists. Throws
+  // std::invalid_argument for n < 1, which has no table.
+  GaussLegendre(int n) : n_(points(n)), x_(gauleg_table(n_)), w_(x_ + n_) {
+  }
+
+  int size() const { return n_; }
+
+  // Abcissas and weights on [-1, 1], the abcissas in increasing order
+  const double* x() const { return x_; }
+  const double* w() const { return w_; }
+
+  // Integral of f(x) from a to b, with f called on one point at a time
+  template<class F>
+  double integrate(F f, double a, double b) const {
+    double xm = 0.5*(b + a), xl = 0.5*(b - a);
+    double sum = 0.0;
+    for (int i=0; i<n_; i++) sum += w_[i]*f(xm + xl*x_[i]);
+    return xl*sum;
+  }
+
+  /*
+  Integrals of f over the m intervals [a[k], b[k]] into result[k]. The
+  integrand is called as f(x, y, count) and must set y[i] = f(x[i]) for
+  i < count; it is given the nodes of several intervals at once, about
+  batch points per call. The points are laid out node by node across the
+  intervals, so that the mapping and the weighted sums run over
+  intervals in the inner loop, without a serial reduction. This pays off
+  when a call of f costs more than one evaluation, e.g. through a
+  function pointer or when f is an interpolation or ODE solve; a small
+  integrand that can be inlined is as fast one interval at a time.
+  */
+  template<class F>
+  void integrate(F f, const double* a, const double* b, size_t m,
+                 double* result, size_t batch = 4096) const {
+    size_t per = batch/n_ > 0 ? batch/n_ : 1;   // intervals per call
+    std::vector<double> xs(per*n_), ys(per*n_), xm(per), xl(per);
+    for (size_t k0=0; k0<m; k0+=per) {
+      size_t nk = m - k0 < per ? m - k0 : per;
+      for (size_t k=0; k<nk; k++) {
+        xm[k] = 0.5*(b[k0+k] + a[k0+k]);
+        xl[k] = 0.5*(b[k0+k] - a[k0+k]);
+        result[k0+k] = 0.0;
+      }
+      for (int i=0; i<n_; i++) {
+        double* xi = &xs[i*nk];
+        for (size_t k=0; k<nk; k++) xi[k] = xm[k] + xl[k]*x_[i];
+      }
+      f((const double*) &xs[0], &ys[0], nk*n_);
+      double* r = result + k0;
+      for (int i=0; i<n_; i++) {
+        const double* yi = &ys[i*nk];
+        for (size_t k=0; k<nk; k++) r[k] += w_[i]*yi[k];
+      }
+      for (size_t k=0; k<nk; k++) r[k] *= xl[k];
+    }
+  }
+
+private:
+  int n_;
+  const double* x_;
+  const double* w_;
+
+  static int points(int n) {
+    if (n < 1) throw std::invalid_argument("GaussLegendre: n < 1");
+    return n;
+  }
+};
+
+    // Points per block of the rules below
+
+const size_t QUADRATURE_BLOCK = 1024;
+
+// Pairwise sum of y[0..n-1]; the rounding error grows as log n, not n
+inline double pairwise_sum(const double* y, size_t n)
+{
+  if (n <= 32) {
+    double sum = 0.0;
+    for (size_t i=0; i<n; i++) sum += y[i];
+    return sum;
+  }
+  size_t half = n/2;
+  return pairwise_sum(y, half) + pairwise_sum(y + half, n - half);
+}
+
+// Neumaier's compensated sum of y[0..n-1]
+inline double compensated_sum(const double* y, size_t n)
+{
+  double sum = 0.0, c = 0.0;
+  for (size_t i=0; i<n; i++) {
+    double t = sum + y[i];
+    if (fabs(sum) >= fabs(y[i])) c += (sum - t) + y[i];
+    else c += (y[i] - t) + sum;
+    sum = t;
+  }
+  return sum + c;
+}
+
+// Array callback evaluating a function object point by point
+template<class F>
+struct Pointwise
+{
+  F f;
+  void operator()(const double* x, double* y, size_t n) const {
+    for (size_t i=0; i<n; i++) y[i] = f(x[i]);
+  }
+};
+
+template<class F>
+Pointwise<F> pointwise(F f)
+{
+  Pointwise<F> p = {f};
+  return p;
+}
+
+/*
+Sum of f(x0 + j h) for j = 0,..,n-1 with the array callback f. Each
+thread takes a contiguous range of blocks, and the block sums are added
+in block order, so the order of summation does not depend on nthreads.
+f must be safe to call from several threads if nthreads > 1. The sum of
+|f(x0 + j h)| is put in abs_sum unless it is null.
+*/
+template<class G>
+double grid_sum(G f, double x0, double h, size_t n, int nthreads = 1,
+                double* abs_sum = 0)
+{
+  size_t nblocks = (n + QUADRATURE_BLOCK - 1)/QUADRATURE_BLOCK;
+  std::vector<double> sums(nblocks), abs_sums(abs_sum ? nblocks : 0);
+  auto work = [&f, &sums, &abs_sums, x0, h, n](size_t first, size_t last) {
+    double x[QUADRATURE_BLOCK], y[QUADRATURE_BLOCK];
+    for (size_t k=first; k<last; k++) {
+      size_t j0 = k*QUADRATURE_BLOCK;
+      size_t m = n - j0 < QUADRATURE_BLOCK ? n - j0 : QUADRATURE_BLOCK;
+      for (size_t i=0; i<m; i++) x[i] = x0 + (double) (j0 + i)*h;
+      f((const double*) x, y, m);
+      sums[k] = pairwise_sum(y, m);
+      if (!abs_sums.empty()) {
+        for (size_t i=0; i<m; i++) y[i] = fabs(y[i]);
+        abs_sums[k] = pairwise_sum(y, m);
+      }
+    }
+  };
+
+  if (nthreads < 1) nthreads = 1;
+  if ((size_t) nthreads > nblocks) nthreads = nblocks > 0 ? nblocks : 1;
+  std::vector<std::thread> workers;
+  for (int t=1; t<nthreads; t++) {
+    workers.push_back(std::thread(work, t*nblocks/nthreads,
+                                  (t + 1)*nblocks/nthreads));
+  }
+  work(0, nblocks/nthreads);
+  for (size_t t=0; t<workers.size(); t++) workers[t].join();
+  if (abs_sum) *abs_sum = compensated_sum(abs_sums.data(), nblocks);
+  return compensated_sum(sums.data(), nblocks);
+}
+
+// Trapezoidal rule with n intervals on [a, b]
+template<class G>
+double trapezoidal_batch(double a, double b, size_t n, G f, int nthreads = 1)
+{
+  double h = (b - a)/n;
+  double ends[2] = {a, b}, fends[2];
+  f((const double*) ends, fends, 2);
+  double inner = n > 1 ? grid_sum(f, a + h, h, n - 1, nthreads) : 0.0;
+  return h*(inner + 0.5*(fends[0] + fends[1]));
+}
+
+template<class F>
+double trapezoidal(double a, double b, size_t n, F f, int nthreads = 1)
+{
+  return trapezoidal_batch(a, b, n, pointwise(f), nthreads);
+}
+
+// Midpoint rule with n intervals on [a, b]
+template<class G>
+double midpoint_batch(double a, double b, size_t n, G f, int nthreads = 1)
+{
+  double h = (b - a)/n;
+  return h*grid_sum(f, a + 0.5*h, h, n, nthreads);
+}
+
+template<class F>
+double midpoint(double a, double b, size_t n, F f, int nthreads = 1)
+{
+  return midpoint_batch(a, b, n, pointwise(f), nthreads);
+}
+
+/*
+Romberg integration of f on [a, b]. The trapezoidal rule is refined by
+halving the step, and each refinement only evaluates f at the new
+midpoints, reusing all earlier values through the previous trapezoidal
+sum. Richardson extrapolation of the sums gives Simpson's rule in the
+first column and higher orders after it. Stops when two successive
+diagonal estimates differ by less than eps times the estimate plus
+abs_tol, returning 0, or returns 1 after kmax refinements. A difference
+at the level of rounding in the integral of |f| is also accepted, so
+that integrals which vanish, e.g. of odd functions on symmetric
+intervals, converge without abs_tol. The estimate is put in result and
+the number of evaluations of f in nfev.
+*/
+template<class G>
+int romberg_batch(double a, double b, G f, double& result, long& nfev,
+                  double eps = 1e-10, int kmax = 20, int nthreads = 1,
+                  double abs_tol = 0.0)
+{
+  std::vector<double> prev(kmax + 1), row(kmax + 1);
+  double ends[2] = {a, b}, fends[2];
+  f((const double*) ends, fends, 2);
+  nfev = 2;
+  double h = b - a;
+  prev[0] = 0.5*h*(fends[0] + fends[1]);
+  result = prev[0];
+  double trap_abs = 0.5*fabs(h)*(fabs(fends[0]) + fabs(fends[1]));
+  for (int k=1; k<=kmax; k++) {
+    size_t nnew = (size_t) 1 << (k - 1);         // new midpoints
+    double new_abs;
+    row[0] = 0.5*prev[0]
+      + 0.5*h*grid_sum(f, a + 0.5*h, h, nnew, nthreads, &new_abs);
+    trap_abs = 0.5*trap_abs + 0.5*fabs(h)*new_abs;
+    nfev += nnew;
+    h *= 0.5;
+    double p4 = 1.0;
+    for (int j=1; j<=k; j++) {
+      p4 *= 4.0;
+      row[j] = row[j-1] + (row[j-1] - prev[j-1])/(p4 - 1.0);
+    }
+    double err = fabs(row[k] - prev[k-1]);
+    result = row[k];
+    prev.swap(row);
+    double tol = eps*fabs(result) + abs_tol + 16*DBL_EPSILON*trap_abs;
+    if (k >= 3 && err <= tol) return 0;
+  }
+  return 1;
+}
+
+template<class F>
+int romberg(double a, double b, F f, double& result, long& nfev,
+            double eps = 1e-10, int kmax = 20, int nthreads = 1,
+            double abs_tol = 0.0)
+{
+  return romberg_batch(a, b, pointwise(f), result, nfev, eps, kmax, nthreads,
+                       abs_tol);
+}
+
+#endif
@@ -0,0 +1,75 @@
+    /*
+     * The definition module
+     *                      rk4.h
+     * for a header-only fourth-order Runge-Kutta stepper. The state
+     * dimension n is a template parameter, so all scratch arrays live on
+     * the stack, and the derivatives are any callable object
+     *       derivs(double x, const double *y, double *dydx)
+     * which the compiler can inline into the stepper.
+     */
+
+#ifndef RK4_H
+#define RK4_H
+
+      /*
+      ** The function
+      **              rk4<n>()
+      ** takes a set of variables y[0:n-1] for the function y(x) together with
+      ** the derivatives dydx[0:n-1] and uses the fourth-order Runge-Kutta
+      ** method to advance the solution over an interval h and return
+      ** incremented variables as yout[0:n-1], which need not be a distinct
+      ** array from y[0:n-1]. No heap memory is used.
+      */
+
+template <int n, class Derivs>
+inline void rk4(const double *y, const double *dydx, double x, double h,
+                double *yout, Derivs &derivs)
+{
+  double   dym[n], dyt[n], yt[n];
+  double   hh = h * 0.5;
+  double   h6 = h/6.0;
+  double   xh = x + hh;
+
+  for(int i = 0; i < n; i++) {             // first step
+    yt[i] = y[i] + hh * dydx[i];
+  }
+
+  derivs(xh, yt, dyt);                      // second step
+
+  for(int i = 0; i < n; i++) {
+    yt[i] = y[i] + hh * dyt[i];
+  }
+
+  derivs(xh, yt, dym);                      // third step
+
+  for(int i = 0; i < n; i++) {
+    yt[i]   = y[i] + h * dym[i];
+    dym[i] += dyt[i];
+  }
+
+  derivs(x + h, yt, dyt);                   // fourth step
+
+        // acummulate increments with proper weights
+
+  for(int i = 0; i < n; i++) {
+    yout[i] = y[i] + h6 * (dydx[i] + dyt[i] + 2.0 * dym[i]);
+  }
+} // End: function rk4<n>()
+
+      /*
+      ** The function
+      **              rk4_step<n>()
+      ** advances y[0:n-1] in place from x to x + h, evaluating the
+      ** derivatives at the start of the interval itself.
+      */
+
+template <int n, class Derivs>
+inline void rk4_step(double *y, double x, double h, Derivs &derivs)
+{
+  double   dydx[n];
+
+  derivs(x, y, dydx);
+  rk4<n>(y, dydx, x, h, y, derivs);
+} // End: function rk4_step<n>()
+
+#endif
@@ -0,0 +1,190 @@
+    /*
+     * The definition module
+     *                      rk45.h
+     * for a header-only adaptive Runge-Kutta integrator based on the
+     * embedded Dormand-Prince 5(4) pair, with error control on every step
+     * and dense output for reporting the solution at given times. As in
+     * rk4.h the state dimension n is a template parameter and the
+     * derivatives are any callable object
+     *       derivs(double x, const double *y, double *dydx)
+     */
+
+#ifndef RK45_H
+#define RK45_H
+
+#include <cmath>
+
+template <int n, class Derivs>
+class RK45
+{
+public:
+  double   rtol;          // relative tolerance per component
+  double   atol;          // absolute tolerance per component
+  double   h0;            // initial step, 0 means estimate it
+  double   hmax;          // largest step allowed, 0 means no limit
+  long     nfev;          // derivative evaluations in last integrate()
+  long     naccept;       // accepted steps in last integrate()
+  long     nreject;       // rejected steps in last integrate()
+
+  RK45(Derivs &derivs, double rtol = 1.0E-6, double atol = 1.0E-9)
+    : rtol(rtol), atol(atol), h0(0.0), hmax(0.0),
+      nfev(0), naccept(0), nreject(0), derivs_(derivs) {
+  }
+
+      /*
+      ** The function
+      **              integrate()
+      ** advances y[0:n-1] from x0 through the increasing report times
+      ** tout[0,..,nout - 1]. At each report time the dense output of the
+      ** step covering it is evaluated and passed to report(k, tout[k], yk).
+      ** Returns 0 on success and 1 if the step size underflows.
+      */
+
+  template <class Report>
+  int integrate(double *y, double x0, const double *tout, int nout,
+                Report report)
+  {
+    double   k1[n], k2[n], k3[n], k4[n], k5[n], k6[n], k7[n];
+    double   yt[n], ynew[n], yk[n], r[5][n];
+    double   x = x0, h, xend;
+    int      k = 0;
+
+    nfev = naccept = nreject = 0;
+    if(nout <= 0) return 0;
+    xend = tout[nout - 1];
+
+    derivs_(x, y, k1);
+    nfev++;
+    h = (h0 > 0.0 ? h0 : initial_step(x, y, k1));
+
+    while(k < nout && tout[k] <= x) {        // report times at the start
+      report(k, tout[k], y);
+      k++;
+    }
+
+    while(k < nout) {
+      if(hmax > 0.0 && h > hmax) h = hmax;
+      if(x + h > xend) h = xend - x;
+      if(h < 1.0E-14 * (fabs(x) + 1.0)) return 1;
+
+      for(int i = 0; i < n; i++) yt[i] = y[i] + h*A21*k1[i];
+      derivs_(x + C2*h, yt, k2);
+      for(int i = 0; i < n; i++) yt[i] = y[i] + h*(A31*k1[i] + A32*k2[i]);
+      derivs_(x + C3*h, yt, k3);
+      for(int i = 0; i < n; i++)
+        yt[i] = y[i] + h*(A41*k1[i] + A42*k2[i] + A43*k3[i]);
+      derivs_(x + C4*h, yt, k4);
+      for(int i = 0; i < n; i++)
+        yt[i] = y[i] + h*(A51*k1[i] + A52*k2[i] + A53*k3[i] + A54*k4[i]);
+      derivs_(x + C5*h, yt, k5);
+      for(int i = 0; i < n; i++)
+        yt[i] = y[i] + h*(A61*k1[i] + A62*k2[i] + A63*k3[i] + A64*k4[i]
+                          + A65*k5[i]);
+      derivs_(x + h, yt, k6);
+      for(int i = 0; i < n; i++)
+        ynew[i] = y[i] + h*(A71*k1[i] + A73*k3[i] + A74*k4[i] + A75*k5[i]
+                            + A76*k6[i]);
+      derivs_(x + h, ynew, k7);
+      nfev += 6;
+
+            // error estimate from the embedded fourth-order solution
+
+      double err = 0.0;
+      for(int i = 0; i < n; i++) {
+        double sc = atol + rtol*fmax(fabs(y[i]), fabs(ynew[i]));
+        double ei = h*(E1*k1[i] + E3*k3[i] + E4*k4[i] + E5*k5[i]
+                       + E6*k6[i] + E7*k7[i])/sc;
+        err += ei*ei;
+      }
+      err = sqrt(err/n);
+
+      if(err > 1.0) {                         // reject and shrink the step
+        h *= fmax(0.2, 0.9*pow(err, -0.2));
+        nreject++;
+        continue;
+      }
+      naccept++;
+
+            // coefficients of the continuous extension of this step
+
+      for(int i = 0; i < n; i++) {
+        double ydiff = ynew[i] - y[i];
+        double bspl  = h*k1[i] - ydiff;
+        r[0][i] = y[i];
+        r[1][i] = ydiff;
+        r[2][i] = bspl;
+        r[3][i] = ydiff - h*k7[i] - bspl;
+        r[4][i] = h*(D1*k1[i] + D3*k3[i] + D4*k4[i] + D5*k5[i]
+                     + D6*k6[i] + D7*k7[i]);
+      }
+
+      while(k < nout && tout[k] <= x + h) {
+        double s  = (tout[k] - x)/h;
+        double s1 = 1.0 - s;
+        for(int i = 0; i < n; i++) {
+          yk[i] = r[0][i] + s*(r[1][i] + s1*(r[2][i] + s*(r[3][i]
+                  + s1*r[4][i])));
+        }
+        report(k, tout[k], yk);
+        k++;
+      }
+
+      x += h;
+      for(int i = 0; i < n; i++) {
+        y[i]  = ynew[i];
+        k1[i] = k7[i];                        // first same as last
+      }
+      h *= fmin(10.0, 0.9*pow(fmax(err, 1.0E-10), -0.2));
+    }
+    return 0;
+  } // End: function integrate()
+
+private:
+  Derivs   &derivs_;
+
+      // Starting step from the size of y and its derivative
+
+  double initial_step(double x, const double *y, const double *dydx)
+  {
+    double d0 = 0.0, d1 = 0.0;
+    (void) x;
+    for(int i = 0; i < n; i++) {
+      double sc = atol + rtol*fabs(y[i]);
+      d0 += (y[i]/sc)*(y[i]/sc);
+      d1 += (dydx[i]/sc)*(dydx[i]/sc);
+    }
+    d0 = sqrt(d0/n);
+    d1 = sqrt(d1/n);
+    if(d0 < 1.0E-5 || d1 < 1.0E-5) return 1.0E-6;
+    return 0.01*d0/d1;
+  }
+
+      // Dormand-Prince coefficients, see Hairer, Norsett and Wanner,
+      // "Solving Ordinary Differential Equations I", sect. II.5
+
+  static constexpr double C2 = 1.0/5.0, C3 = 3.0/10.0, C4 = 4.0/5.0,
+                          C5 = 8.0/9.0;
+  static constexpr double A21 = 1.0/5.0;
+  static constexpr double A31 = 3.0/40.0, A32 = 9.0/40.0;
+  static constexpr double A41 = 44.0/45.0, A42 = -56.0/15.0,
+                          A43 = 32.0/9.0;
+  static constexpr double A51 = 19372.0/6561.0, A52 = -25360.0/2187.0,
+                          A53 = 64448.0/6561.0, A54 = -212.0/729.0;
+  static constexpr double A61 = 9017.0/3168.0, A62 = -355.0/33.0,
+                          A63 = 46732.0/5247.0, A64 = 49.0/176.0,
+                          A65 = -5103.0/18656.0;
+  static constexpr double A71 = 35.0/384.0, A73 = 500.0/1113.0,
+                          A74 = 125.0/192.0, A75 = -2187.0/6784.0,
+                          A76 = 11.0/84.0;
+  static constexpr double E1 = 71.0/57600.0, E3 = -71.0/16695.0,
+                          E4 = 71.0/1920.0, E5 = -17253.0/339200.0,
+                          E6 = 22.0/525.0, E7 = -1.0/40.0;
+  static constexpr double D1 = -12715105075.0/11282082432.0,
+                          D3 = 87487479700.0/32700410799.0,
+                          D4 = -10690763975.0/1880347072.0,
+                          D5 = 701980252875.0/199316789632.0,
+                          D6 = -1453857185.0/822651844.0,
+                          D7 = 69997945.0/29380423.0;
+};
+
+#endif
@@ -0,0 +1,200 @@
+    /*
+     * The definition module
+     *                      rk4_batch.h
+     * for integrating many SIRS scenarios at once with RK4. The scenarios
+     * are stored as structure of arrays (S[], I[], R[] and one array per
+     * rate), and one RK4 step advances all of them. The inner kernel is
+     * written once over a lane type V and instantiated for AVX-512 (8
+     * lanes), AVX2 (4 lanes) or plain double, depending on the
+     * instruction set the compiler targets (e.g. -march=native).
+     *
+     * The equations are those of Population in main_rk4.cpp without
+     * vaccination (f = 0) and with the default mean transmission a0 = 4:
+     *   dS/dt = c R - a(t) S I/N - d S + e N
+     *   dI/dt = a(t) S I/N - b I - d I - dI I
+     *   dR/dt = b I - c R - d I
+     * with the seasonal transmission a(t) = cos(0.05 t) + 4.
+     */
+
+#ifndef RK4_BATCH_H
+#define RK4_BATCH_H
+
+#include <cmath>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+    // Lane types: width, load/store and broadcast for each vector width
+
+struct ScalarLanes
+{
+  typedef double V;
+  static const int width = 1;
+  static V load(const double *p) { return *p; }
+  static void store(double *p, V v) { *p = v; }
+  static V set1(double x) { return x; }
+};
+
+#ifdef __AVX2__
+struct Vec4d
+{
+  __m256d v;
+  Vec4d() {}
+  Vec4d(__m256d x) : v(x) {}
+};
+
+inline Vec4d operator+(Vec4d a, Vec4d b) { return _mm256_add_pd(a.v, b.v); }
+inline Vec4d operator-(Vec4d a, Vec4d b) { return _mm256_sub_pd(a.v, b.v); }
+inline Vec4d operator*(Vec4d a, Vec4d b) { return _mm256_mul_pd(a.v, b.v); }
+
+struct AVX2Lanes
+{
+  typedef Vec4d V;
+  static const int width = 4;
+  static V load(const double *p) { return _mm256_loadu_pd(p); }
+  static void store(double *p, V v) { _mm256_storeu_pd(p, v.v); }
+  static V set1(double x) { return _mm256_set1_pd(x); }
+};
+#endif
+
+#ifdef __AVX512F__
+struct Vec8d
+{
+  __m512d v;
+  Vec8d() {}
+  Vec8d(__m512d x) : v(x) {}
+};
+
+inline Vec8d operator+(Vec8d a, Vec8d b) { return _mm512_add_pd(a.v, b.v); }
+inline Vec8d operator-(Vec8d a, Vec8d b) { return _mm512_sub_pd(a.v, b.v); }
+inline Vec8d operator*(Vec8d a, Vec8d b) { return _mm512_mul_pd(a.v, b.v); }
+
+struct AVX512Lanes
+{
+  typedef Vec8d V;
+  static const int width = 8;
+  static V load(const double *p) { return _mm512_loadu_pd(p); }
+  static void store(double *p, V v) { _mm512_storeu_pd(p, v.v); }
+  static V set1(double x) { return _mm512_set1_pd(x); }
+};
+#endif
+
+#if defined(__AVX512F__)
+typedef AVX512Lanes NativeLanes;
+#elif defined(__AVX2__)
+typedef AVX2Lanes NativeLanes;
+#else
+typedef ScalarLanes NativeLanes;
+#endif
+
+class SIRSBatch
+{
+public:
+  std::vector<double> S, I, R;          // state of each scenario
+  std::vector<double> N;                // population size used in a S I/N
+  std::vector<double> b, c, d, dI, e;   // rates as in Population
+
+  int size() const {
+    return S.size();
+  }
+
+  // Adding a scenario with the arguments of Population::initiate()
+  void add(double S0, double I0, double R0, double birth_rate,
+           double imloss_rate, double death_rate, double death_inf_rate) {
+    S.push_back(S0);
+    I.push_back(I0);
+    R.push_back(R0);
+    N.push_back(S0 + I0 + R0);
+    b.push_back(birth_rate);
+    c.push_back(imloss_rate);
+    d.push_back(death_rate);
+    dI.push_back(death_inf_rate);
+    e.push_back(birth_rate);
+  }
+
+  static double a(double t) {
+    // Seasonal variation of a
+    return 1.0*cos(0.05*t) + 4.0;
+  }
+
+  // Advancing every scenario from t to t + h with the widest lanes
+  void step(double t, double h) {
+    step_lanes<NativeLanes>(t, h);
+  }
+
+  // Same, but with a given lane type, e.g. ScalarLanes for comparison
+  template <class L>
+  void step_lanes(double t, double h) {
+    int n = size();
+    int i = 0;
+    double a0 = a(t), a1 = a(t + 0.5*h), a2 = a(t + h);
+    // Recomputed every step, since N may have been changed by the caller
+    invN_.resize(n);
+    for (int k=0; k<n; k++) invN_[k] = 1.0/N[k];
+    for (; i + L::width <= n; i += L::width) step_block<L>(i, a0, a1, a2, h);
+    for (; i < n; i++) step_block<ScalarLanes>(i, a0, a1, a2, h);
+  }
+
+  // Taking steps of length h from t = 0, calling report(k) after step k
+  template <class Report>
+  void integrate(double h, int steps, Report report) {
+    for (int k=0; k<steps-1; k++) {
+      step(k*h, h);
+      report(k+1);
+    }
+  }
+
+private:
+  template <class V>
+  struct Rates
+  {
+    V invN, eN, b, c, d, bdI;
+  };
+
+  template <class V>
+  static inline void derivs(V a, const Rates<V> &p, V s, V i, V r,
+                            V &ds, V &di, V &dr) {
+    V inf = a*s*i*p.invN;
+    ds = p.c*r - inf - p.d*s + p.eN;
+    di = inf - p.bdI*i;
+    dr = p.b*i - p.c*r - p.d*i;
+  }
+
+  // One RK4 step for the L::width scenarios starting at index j,
+  // with the whole step kept in registers
+  template <class L>
+  inline void step_block(int j, double a0, double a1, double a2, double h) {
+    typedef typename L::V V;
+    Rates<V> p;
+    V N_ = L::load(&N[j]);
+    p.invN = L::load(&invN_[j]);
+    p.eN   = L::load(&e[j])*N_;
+    p.b    = L::load(&b[j]);
+    p.c    = L::load(&c[j]);
+    p.d    = L::load(&d[j]);
+    p.bdI  = p.b + p.d + L::load(&dI[j]);
+
+    V hh = L::set1(0.5*h), hv = L::set1(h), h6 = L::set1(h/6.0);
+    V two = L::set1(2.0);
+    V s = L::load(&S[j]), i = L::load(&I[j]), r = L::load(&R[j]);
+    V ds1, di1, dr1, ds2, di2, dr2, ds3, di3, dr3, ds4, di4, dr4;
+
+    derivs<V>(L::set1(a0), p, s, i, r, ds1, di1, dr1);
+    derivs<V>(L::set1(a1), p, s + hh*ds1, i + hh*di1, r + hh*dr1,
+              ds2, di2, dr2);
+    derivs<V>(L::set1(a1), p, s + hh*ds2, i + hh*di2, r + hh*dr2,
+              ds3, di3, dr3);
+    derivs<V>(L::set1(a2), p, s + hv*ds3, i + hv*di3, r + hv*dr3,
+              ds4, di4, dr4);
+
+    L::store(&S[j], s + h6*(ds1 + two*(ds2 + ds3) + ds4));
+    L::store(&I[j], i + h6*(di1 + two*(di2 + di3) + di4));
+    L::store(&R[j], r + h6*(dr1 + two*(dr2 + dr3) + dr4));
+  }
+
+  std::vector<double> invN_;   // 1/N, filled at each step
+};
+
+#endif
@@ -0,0 +1,333 @@
+    /*
+     * The definition module
+     *                      roots.h
+     * for solving many independent equations f_i(x) = 0 together, as the
+     * batched counterparts of rtbis(), rtsec(), rtnewt() and zbrent() in
+     * lib.cpp. The equations are taken in blocks of lanes which advance in
+     * lock-step: each iteration calls the function once on the whole
+     * block, and a lane that has converged or failed is masked out and
+     * keeps its value while the others go on. Nothing is printed and the
+     * program is not stopped; every lane gets a status and an iteration
+     * count instead.
+     *
+     * The function is a function object called as
+     *   f(x, y, first, n)
+     * which must set y[i] = f_(first + i)(x[i]) for i < n, so it knows
+     * which equation each lane holds and can vectorize over the lanes.
+     * For rtnewt_batch() it is called as fd(x, y, dy, first, n) and also
+     * sets the derivatives dy[i]. lanewise() makes such an object from a
+     * scalar f(i, x).
+     */
+
+#ifndef ROOTS_H
+#define ROOTS_H
+
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+
+    // Status of each lane
+
+const int ROOT_OK = 0;                   // converged to within xacc
+const int ROOT_NOT_BRACKETED = 1;        // f(x1) and f(x2) of equal sign
+const int ROOT_MAX_ITERATIONS = 2;       // no convergence in maxit steps
+const int ROOT_OUT_OF_BRACKET = 3;       // Newton step left [x1, x2]
+
+    // Lanes per block
+
+const size_t ROOTS_BLOCK = 256;
+
+// Array function object evaluating a scalar f(i, x) lane by lane
+template<class F>
+struct Lanewise
+{
+  F f;
+  void operator()(const double* x, double* y, size_t first, size_t n) const {
+    for (size_t i=0; i<n; i++) y[i] = f(first + i, x[i]);
+  }
+};
+
+template<class F>
+Lanewise<F> lanewise(F f)
+{
+  Lanewise<F> l = {f};
+  return l;
+}
+
+// Number of lanes of status[0..m-1] which are not ROOT_OK
+inline size_t count_failed(const int* status, size_t m)
+{
+  size_t failed = 0;
+  for (size_t k=0; k<m; k++) failed += status[k] != ROOT_OK;
+  return failed;
+}
+
+/*
+Bisection for the roots of the m equations, equation k bracketed by
+x1[k] and x2[k], as rtbis(). The root is put in root[k] to within
+xacc, its status in status[k] and the number of evaluations after the
+two at the ends in iter[k] unless iter is null. Returns the number of
+lanes which failed.
+*/
+template<class F>
+size_t rtbis_batch(F f, const double* x1, const double* x2, size_t m,
+                   double xacc, double* root, int* status, int* iter = 0,
+                   int maxit = 60)
+{
+  double fa[ROOTS_BLOCK], fb[ROOTS_BLOCK], dx[ROOTS_BLOCK];
+  double xmid[ROOTS_BLOCK], fmid[ROOTS_BLOCK];
+  int done[ROOTS_BLOCK];
+  for (size_t k0=0; k0<m; k0+=ROOTS_BLOCK) {
+    size_t nk = m - k0 < ROOTS_BLOCK ? m - k0 : ROOTS_BLOCK;
+    double* rtb = root + k0;
+    int* st = status + k0;
+    f(x1 + k0, fa, k0, nk);
+    f(x2 + k0, fb, k0, nk);
+    size_t active = 0;
+    for (size_t k=0; k<nk; k++) {
+      double a = x1[k0+k], b = x2[k0+k];
+      bool low = fa[k] < 0.0;
+      rtb[k] = low ? a : b;
+      dx[k] = low ? b - a : a - b;
+      done[k] = fa[k]*fb[k] > 0.0 || fa[k] != fa[k] || fb[k] != fb[k];
+      st[k] = done[k] ? ROOT_NOT_BRACKETED : ROOT_MAX_ITERATIONS;
+      if (fa[k] == 0.0 || fb[k] == 0.0) {
+        rtb[k] = fa[k] == 0.0 ? a : b;
+        done[k] = 1;
+        st[k] = ROOT_OK;
+      }
+      if (iter) iter[k0+k] = 0;
+      active += !done[k];
+    }
+    for (int j=0; j<maxit && active > 0; j++) {
+      for (size_t k=0; k<nk; k++) {
+        dx[k] = done[k] ? dx[k] : 0.5*dx[k];
+        xmid[k] = rtb[k] + dx[k];
+      }
+      f((const double*) xmid, fmid, k0, nk);
+      active = 0;
+      for (size_t k=0; k<nk; k++) {
+        if (done[k]) continue;
+        if (fmid[k] <= 0.0) rtb[k] = xmid[k];
+        if (iter) iter[k0+k]++;
+        if (fabs(dx[k]) < xacc || fmid[k] == 0.0) {
+          done[k] = 1;
+          st[k] = ROOT_OK;
+        }
+        active += !done[k];
+      }
+    }
+  }
+  return count_failed(status, m);
+}
+
+/*
+The secant method for the m equations from the points x1[k] and x2[k],
+as rtsec(); the root need not be bracketed, nor is it kept within the
+two points. Arguments and return value as for rtbis_batch().
+*/
+template<class F>
+size_t rtsec_batch(F f, const double* x1, const double* x2, size_t m,
+                   double xacc, double* root, int* status, int* iter = 0,
+                   int maxit = 30)
+{
+  double fl[ROOTS_BLOCK], fr[ROOTS_BLOCK], xl[ROOTS_BLOCK];
+  int done[ROOTS_BLOCK];
+  for (size_t k0=0; k0<m; k0+=ROOTS_BLOCK) {
+    size_t nk = m - k0 < ROOTS_BLOCK ? m - k0 : ROOTS_BLOCK;
+    double* rts = root + k0;
+    int* st = status + k0;
+    f(x1 + k0, fl, k0, nk);
+    f(x2 + k0, fr, k0, nk);
+    for (size_t k=0; k<nk; k++) {
+      // Start from the point with the smaller |f|
+      bool swap = fabs(fl[k]) < fabs(fr[k]);
+      double a = x1[k0+k], b = x2[k0+k], fa = fl[k], fb = fr[k];
+      xl[k] = swap ? b : a;
+      rts[k] = swap ? a : b;
+      fl[k] = swap ? fb : fa;
+      fr[k] = swap ? fa : fb;
+      done[k] = 0;
+      st[k] = ROOT_MAX_ITERATIONS;
+      if (iter) iter[k0+k] = 0;
+    }
+    size_t active = nk;
+    for (int j=0; j<maxit && active > 0; j++) {
+      double dx[ROOTS_BLOCK];
+      for (size_t k=0; k<nk; k++) {
+        dx[k] = done[k] ? 0.0 : (xl[k] - rts[k])*fr[k]/(fr[k] - fl[k]);
+        xl[k] = done[k] ? xl[k] : rts[k];
+        fl[k] = done[k] ? fl[k] : fr[k];
+        rts[k] += dx[k];
+      }
+      double fnew[ROOTS_BLOCK];
+      f((const double*) rts, fnew, k0, nk);
+      active = 0;
+      for (size_t k=0; k<nk; k++) {
+        if (done[k]) continue;
+        fr[k] = fnew[k];
+        if (iter) iter[k0+k]++;
+        if (fabs(dx[k]) < xacc || fr[k] == 0.0) {
+          done[k] = 1;
+          st[k] = ROOT_OK;
+        }
+        else if (!std::isfinite(rts[k])) {
+          done[k] = 1;             // f(xl) == f(rts): no secant step
+        }
+        active += !done[k];
+      }
+    }
+  }
+  return count_failed(status, m);
+}
+
+/*
+Newton-Raphson for the m equations from the midpoints of [x1[k], x2[k]],
+as rtnewt(). A lane whose iterate leaves its interval stops with
+ROOT_OUT_OF_BRACKET and the last iterate in root[k]. Arguments and
+return value otherwise as for rtbis_batch().
+*/
+template<class FD>
+size_t rtnewt_batch(FD fd, const double* x1, const double* x2, size_t m,
+                    double xacc, double* root, int* status, int* iter = 0,
+                    int maxit = 20)
+{
+  double fv[ROOTS_BLOCK], df[ROOTS_BLOCK];
+  int done[ROOTS_BLOCK];
+  for (size_t k0=0; k0<m; k0+=ROOTS_BLOCK) {
+    size_t nk = m - k0 < ROOTS_BLOCK ? m - k0 : ROOTS_BLOCK;
+    double* rtn = root + k0;
+    int* st = status + k0;
+    for (size_t k=0; k<nk; k++) {
+      rtn[k] = 0.5*(x1[k0+k] + x2[k0+k]);
+      done[k] = 0;
+      st[k] = ROOT_MAX_ITERATIONS;
+      if (iter) iter[k0+k] = 0;
+    }
+    size_t active = nk;
+    for (int j=0; j<maxit && active > 0; j++) {
+      fd((const double*) rtn, fv, df, k0, nk);
+      active = 0;
+      for (size_t k=0; k<nk; k++) {
+        if (done[k]) continue;
+        double dx = fv[k]/df[k];
+        rtn[k] -= dx;
+        if (iter) iter[k0+k]++;
+        if ((x1[k0+k] - rtn[k])*(rtn[k] - x2[k0+k]) < 0.0 || dx != dx) {
+          done[k] = 1;
+          st[k] = ROOT_OUT_OF_BRACKET;
+        }
+        else if (fabs(dx) < xacc) {
+          done[k] = 1;
+          st[k] = ROOT_OK;
+        }
+        active += !done[k];
+      }
+    }
+  }
+  return count_failed(status, m);
+}
+
+/*
+Brent's method for the m equations, equation k bracketed by x1[k] and
+x2[k], as zbrent(): inverse quadratic interpolation where it makes
+progress, bisection otherwise. The relative part of the tolerance is the
+machine precision of doubles. Arguments and return value as for
+rtbis_batch().
+*/
+template<class F>
+size_t zbrent_batch(F f, const double* x1, const double* x2, size_t m,
+                    double xacc, double* root, int* status, int* iter = 0,
+                    int maxit = 100)
+{
+  double a[ROOTS_BLOCK], c[ROOTS_BLOCK], d[ROOTS_BLOCK], e[ROOTS_BLOCK];
+  double fa[ROOTS_BLOCK], fb[ROOTS_BLOCK], fc[ROOTS_BLOCK], fnew[ROOTS_BLOCK];
+  int done[ROOTS_BLOCK];
+  for (size_t k0=0; k0<m; k0+=ROOTS_BLOCK) {
+    size_t nk = m - k0 < ROOTS_BLOCK ? m - k0 : ROOTS_BLOCK;
+    double* b = root + k0;
+    int* st = status + k0;
+    f(x1 + k0, fa, k0, nk);
+    f(x2 + k0, fb, k0, nk);
+    size_t active = 0;
+    for (size_t k=0; k<nk; k++) {
+      a[k] = x1[k0+k];
+      b[k] = c[k] = x2[k0+k];
+      fc[k] = fb[k];
+      d[k] = e[k] = b[k] - a[k];
+      done[k] = (fa[k] > 0.0 && fb[k] > 0.0) || (fa[k] < 0.0 && fb[k] < 0.0)
+        || fa[k] != fa[k] || fb[k] != fb[k];
+      st[k] = done[k] ? ROOT_NOT_BRACKETED : ROOT_MAX_ITERATIONS;
+      if (iter) iter[k0+k] = 0;
+      active += !done[k];
+    }
+    for (int j=0; j<=maxit && active > 0; j++) {
+      for (size_t k=0; k<nk; k++) {
+        if (done[k]) continue;
+        if ((fb[k] > 0.0 && fc[k] > 0.0) || (fb[k] < 0.0 && fc[k] < 0.0)) {
+          c[k] = a[k];              // b and c must bracket the root
+          fc[k] = fa[k];
+          e[k] = d[k] = b[k] - a[k];
+        }
+        if (fabs(fc[k]) < fabs(fb[k])) {
+          a[k] = b[k];
+          b[k] = c[k];
+          c[k] = a[k];
+          fa[k] = fb[k];
+          fb[k] = fc[k];
+          fc[k] = fa[k];
+        }
+        double tol = 2.0*DBL_EPSILON*fabs(b[k]) + 0.5*xacc;
+        double xm = 0.5*(c[k] - b[k]);
+        if (fabs(xm) <= tol || fb[k] == 0.0) {
+          done[k] = 1;
+          st[k] = ROOT_OK;
+          continue;
+        }
+        if (j == maxit) continue;   // out of iterations: no new point
+        if (fabs(e[k]) >= tol && fabs(fa[k]) > fabs(fb[k])) {
+          double p, q, r, s = fb[k]/fa[k];
+          if (a[k] == c[k]) {
+            p = 2.0*xm*s;
+            q = 1.0 - s;
+          }
+          else {
+            q = fa[k]/fc[k];
+            r = fb[k]/fc[k];
+            p = s*(2.0*xm*q*(q - r) - (b[k] - a[k])*(r - 1.0));
+            q = (q - 1.0)*(r - 1.0)*(s - 1.0);
+          }
+          if (p > 0.0) q = -q;
+          p = fabs(p);
+          double min1 = 3.0*xm*q - fabs(tol*q), min2 = fabs(e[k]*q);
+          if (2.0*p < (min1 < min2 ? min1 : min2)) {
+            e[k] = d[k];            // accept the interpolation
+            d[k] = p/q;
+          }
+          else {
+            d[k] = xm;              // bisect
+            e[k] = d[k];
+          }
+        }
+        else {
+          d[k] = xm;
+          e[k] = d[k];
+        }
+        a[k] = b[k];
+        fa[k] = fb[k];
+        b[k] += fabs(d[k]) > tol ? d[k] : (xm < 0.0 ? -tol : tol);
+        if (iter) iter[k0+k]++;
+      }
+      active = 0;
+      for (size_t k=0; k<nk; k++) active += !done[k];
+      if (j == maxit || active == 0) break;
+      f((const double*) b, fnew, k0, nk);
+      for (size_t k=0; k<nk; k++) {
+        if (!done[k]) fb[k] = fnew[k];
+      }
+    }
+  }
+  return count_failed(status, m);
+}
+
+#endif
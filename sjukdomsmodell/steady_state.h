@@ -0,0 +1,330 @@
+    /*
+     * The definition module
+     *                      steady_state.h
+     * for the equilibria of the SIRS models without integrating in time.
+     * The rates are those of main_rk4.cpp,
+     *   dS/dt = c R - a S I/N - d S + e N - f S
+     *   dI/dt = a S I/N - b I - d I - dI I
+     *   dR/dt = b I - c R - d I + f S
+     * and main_mc.cpp is the case d = dI = e = f = 0, where S + I + R = N
+     * is conserved. The disease-free (I = 0) and endemic (I > 0)
+     * equilibria have closed forms, which start a Newton iteration with
+     * the analytic Jacobian, solved with ludcmp() and lubksb() from
+     * lib.cpp. The eigenvalues of the Jacobian at the equilibrium tell
+     * whether it is stable.
+     */
+
+#ifndef STEADY_STATE_H
+#define STEADY_STATE_H
+
+#include <cmath>
+#include <iomanip>
+#include <ostream>
+#include "lib.h"
+
+struct SIRSParameters
+{
+  double N;               // population size in the rates
+  double a;               // rate of transmission
+  double b;               // rate of recovery
+  double c;               // rate of immunity loss
+  double d;               // death rate
+  double dI;              // death rate of infected people due to disease
+  double e;               // birth rate
+  double f;               // vaccination rate
+
+  // Whether S + I + R stays constant, so one equation is redundant
+  bool conserved() const {
+    return d == 0.0 && dI == 0.0 && e == 0.0;
+  }
+
+  // Basic reproduction number at the disease-free equilibrium S
+  double reproduction_number(double S) const {
+    return a*S/(N*(b + d + dI));
+  }
+};
+
+    // Status of an equilibrium
+
+const int STEADY_OK = 0;
+const int STEADY_NONE = 1;              // not in the positive octant
+const int STEADY_SINGULAR = 2;          // Jacobian singular in Newton
+const int STEADY_NO_CONVERGENCE = 3;
+
+    // Stability from the eigenvalues of the Jacobian
+
+const int STABLE = 0;                   // all real parts negative
+const int UNSTABLE = 1;                 // some real part positive
+const int MARGINAL = 2;                 // largest real part zero
+
+struct Equilibrium
+{
+  double S, I, R;
+  int status;
+  int iterations;         // Newton steps taken
+  int neig;               // 2 when S + I + R is conserved, else 3
+  double re[3], im[3];    // eigenvalues of the Jacobian
+  int stability;
+
+  // Whether perturbations decay, or grow, in damped oscillations
+  bool oscillating() const {
+    for (int k=0; k<neig; k++) if (im[k] != 0.0) return true;
+    return false;
+  }
+};
+
+inline const char* stability_name(int stability)
+{
+  if (stability == STABLE) return "stable";
+  if (stability == UNSTABLE) return "unstable";
+  return "marginal";
+}
+
+// dS/dt, dI/dt and dR/dt at y = (S, I, R)
+inline void sirs_rates(const SIRSParameters& p, const double* y, double* dydt)
+{
+  double inf = p.a*y[0]*y[1]/p.N;
+  dydt[0] = p.c*y[2] - inf - p.d*y[0] + p.e*p.N - p.f*y[0];
+  dydt[1] = inf - p.b*y[1] - p.d*y[1] - p.dI*y[1];
+  dydt[2] = p.b*y[1] - p.c*y[2] - p.d*y[1] + p.f*y[0];
+}
+
+// The Jacobian of the rates at y, row by row in jac[0..8]
+inline void sirs_jacobian(const SIRSParameters& p, const double* y,
+                          double* jac)
+{
+  double as = p.a*y[0]/p.N, ai = p.a*y[1]/p.N;
+  jac[0] = -ai - p.d - p.f;  jac[1] = -as;                      jac[2] = p.c;
+  jac[3] = ai;               jac[4] = as - p.b - p.d - p.dI;    jac[5] = 0.0;
+  jac[6] = p.f;              jac[7] = p.b - p.d;                jac[8] = -p.c;
+}
+
+/*
+Newton's method for the rates being zero, starting from y. When S + I + R
+is conserved the last equation is replaced by S + I + R = N, which makes
+the system nonsingular. Returns STEADY_OK when the rates or the step are
+below tol relative to the population, STEADY_SINGULAR if the Jacobian has
+a zero row, e.g. at the disease-free equilibrium when R_0 = 1, and
+STEADY_NO_CONVERGENCE after maxit iterations.
+*/
+inline int steady_newton(const SIRSParameters& p, double* y, int& iterations,
+                         double tol = 1e-12, int maxit = 50)
+{
+  double jac[9], g[3], dd;
+  int indx[3];
+  double rate = p.a + p.b + p.c + p.d + p.dI + p.e + p.f;
+  for (iterations=0; iterations<maxit; iterations++) {
+    sirs_rates(p, y, g);
+    sirs_jacobian(p, y, jac);
+    if (p.conserved()) {
+      g[2] = rate*(y[0] + y[1] + y[2] - p.N);
+      jac[6] = jac[7] = jac[8] = rate;
+    }
+    if (fmax(fabs(g[0]), fmax(fabs(g[1]), fabs(g[2]))) <= tol*rate*p.N) {
+      return STEADY_OK;
+    }
+    for (int i=0; i<3; i++) {
+      if (jac[3*i] == 0.0 && jac[3*i+1] == 0.0 && jac[3*i+2] == 0.0) {
+        return STEADY_SINGULAR;
+      }
+    }
+    ludcmp(jac, 3, indx, &dd);
+    lubksb(jac, 3, indx, g, 1);
+    double step = 0.0;
+    for (int i=0; i<3; i++) {
+      y[i] -= g[i];
+      step = fmax(step, fabs(g[i]));
+    }
+    if (!(step == step)) return STEADY_SINGULAR;
+    if (step <= tol*p.N) {
+      iterations++;
+      return STEADY_OK;
+    }
+  }
+  return STEADY_NO_CONVERGENCE;
+}
+
+/*
+The roots of x^3 + c2 x^2 + c1 x + c0 in re[0..2] and im[0..2], by the
+trigonometric method for three real roots and Cardano's formula
+otherwise. The real root is refined by a Newton step and the others
+found from the remaining quadratic.
+*/
+inline void cubic_roots(double c2, double c1, double c0, double* re,
+                        double* im)
+{
+  double p = c1 - c2*c2/3.0;
+  double q = 2.0*c2*c2*c2/27.0 - c2*c1/3.0 + c0;
+  double disc = 0.25*q*q + p*p*p/27.0;
+  double x;
+  if (disc <= 0.0 && p < 0.0) {
+    double r = 2.0*sqrt(-p/3.0);
+    double arg = 3.0*q/(p*r);
+    arg = arg > 1.0 ? 1.0 : (arg < -1.0 ? -1.0 : arg);
+    x = r*cos(acos(arg)/3.0) - c2/3.0;
+  }
+  else {
+    double s = sqrt(disc > 0.0 ? disc : 0.0);
+    x = cbrt(-0.5*q + s) + cbrt(-0.5*q - s) - c2/3.0;
+  }
+  double fx = ((x + c2)*x + c1)*x + c0, dfx = (3.0*x + 2.0*c2)*x + c1;
+  if (dfx != 0.0) x -= fx/dfx;
+  re[0] = x;
+  im[0] = 0.0;
+
+  // x^2 + b1 x + b0 is what is left after dividing by (x - re[0])
+  double b1 = c2 + x, b0 = c1 + x*b1;
+  double dq = 0.25*b1*b1 - b0;
+  if (dq >= 0.0) {
+    double sq = sqrt(dq);
+    re[1] = -0.5*b1 + sq;
+    re[2] = -0.5*b1 - sq;
+    im[1] = im[2] = 0.0;
+  }
+  else {
+    re[1] = re[2] = -0.5*b1;
+    im[1] = sqrt(-dq);
+    im[2] = -im[1];
+  }
+}
+
+/*
+The eigenvalues of the Jacobian at an equilibrium and its stability.
+When S + I + R is conserved the Jacobian always has the eigenvalue 0
+along the conserved sum, which is left out, and the other two are the
+roots of the characteristic polynomial divided by the eigenvalue.
+*/
+inline void classify(const SIRSParameters& p, Equilibrium& eq)
+{
+  double y[3] = {eq.S, eq.I, eq.R}, j[9];
+  sirs_jacobian(p, y, j);
+  double tr = j[0] + j[4] + j[8];
+  double m2 = j[0]*j[4] - j[1]*j[3] + j[0]*j[8] - j[2]*j[6]
+    + j[4]*j[8] - j[5]*j[7];
+  double det = j[0]*(j[4]*j[8] - j[5]*j[7]) - j[1]*(j[3]*j[8] - j[5]*j[6])
+    + j[2]*(j[3]*j[7] - j[4]*j[6]);
+
+  if (p.conserved()) {
+    eq.neig = 2;
+    double dq = 0.25*tr*tr - m2;        // x^2 - tr x + m2
+    if (dq >= 0.0) {
+      eq.re[0] = 0.5*tr + sqrt(dq);
+      eq.re[1] = 0.5*tr - sqrt(dq);
+      eq.im[0] = eq.im[1] = 0.0;
+    }
+    else {
+      eq.re[0] = eq.re[1] = 0.5*tr;
+      eq.im[0] = sqrt(-dq);
+      eq.im[1] = -eq.im[0];
+    }
+    eq.re[2] = eq.im[2] = 0.0;
+  }
+  else {
+    eq.neig = 3;
+    cubic_roots(-tr, m2, -det, eq.re, eq.im);
+  }
+
+  double remax = eq.re[0], scale = fabs(tr) + 1.0;
+  for (int k=1; k<eq.neig; k++) remax = fmax(remax, eq.re[k]);
+  if (remax > 1e-12*scale) eq.stability = UNSTABLE;
+  else if (remax < -1e-12*scale) eq.stability = STABLE;
+  else eq.stability = MARGINAL;
+}
+
+// Newton from the closed form y, then the stability of the result
+inline Equilibrium solve_equilibrium(const SIRSParameters& p, const double* y0)
+{
+  Equilibrium eq;
+  double y[3] = {y0[0], y0[1], y0[2]};
+  eq.status = steady_newton(p, y, eq.iterations);
+  eq.S = y[0];
+  eq.I = y[1];
+  eq.R = y[2];
+  eq.neig = 0;
+  eq.stability = MARGINAL;
+  if (eq.status == STEADY_OK) classify(p, eq);
+  return eq;
+}
+
+/*
+The equilibrium without disease. S and R balance births against deaths
+and vaccination against loss of immunity; with no births or deaths the
+population N is split between them in proportion c : f.
+*/
+inline Equilibrium disease_free(const SIRSParameters& p)
+{
+  double y[3] = {0.0, 0.0, 0.0};
+  if (p.conserved()) {
+    y[0] = p.c + p.f > 0.0 ? p.N*p.c/(p.c + p.f) : p.N;
+    y[2] = p.N - y[0];
+  }
+  else {
+    y[0] = p.d > 0.0 ? p.e*p.N/p.d : p.N;
+    y[2] = p.c > 0.0 ? p.f*y[0]/p.c : 0.0;
+  }
+  return solve_equilibrium(p, y);
+}
+
+/*
+The equilibrium with the disease present, where S = N(b + d + dI)/a
+keeps the number of infected constant. It only exists when I > 0 there,
+i.e. when the reproduction number at the disease-free equilibrium
+exceeds 1; otherwise the status is STEADY_NONE.
+*/
+inline Equilibrium endemic(const SIRSParameters& p)
+{
+  double y[3];
+  y[0] = p.N*(p.b + p.d + p.dI)/p.a;
+  if (p.conserved()) {
+    y[1] = (p.c*(p.N - y[0]) - p.f*y[0])/(p.b + p.c);
+    y[2] = p.N - y[0] - y[1];
+  }
+  else {
+    y[1] = (p.e*p.N - p.d*y[0])/(2.0*p.d + p.dI);
+    y[2] = p.c > 0.0 ? ((p.b - p.d)*y[1] + p.f*y[0])/p.c : 0.0;
+  }
+  if (!(y[1] > 0.0) || !(y[2] >= 0.0)) {
+    Equilibrium none = {y[0], y[1], y[2], STEADY_NONE, 0, 0,
+                        {0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}, MARGINAL};
+    return none;
+  }
+  return solve_equilibrium(p, y);
+}
+
+// Equilibrium the population ends up in: the endemic one if it exists,
+// otherwise the disease-free one
+inline Equilibrium long_run(const SIRSParameters& p)
+{
+  Equilibrium eq = endemic(p);
+  return eq.status == STEADY_OK ? eq : disease_free(p);
+}
+
+// Printing the reproduction number and both equilibria with their
+// eigenvalues
+inline void print_equilibria(std::ostream& out, const SIRSParameters& p)
+{
+  Equilibrium eqs[2] = {disease_free(p), endemic(p)};
+  const char* kind[2] = {"disease-free", "endemic"};
+  out << "R_0 = " << p.reproduction_number(eqs[0].S) << std::endl;
+  for (int k=0; k<2; k++) {
+    out << "  " << std::setw(14) << std::left << kind[k] << std::right;
+    if (eqs[k].status != STEADY_OK) {
+      out << "none" << std::endl;
+      continue;
+    }
+    out << "S = " << std::setw(10) << eqs[k].S
+        << " I = " << std::setw(10) << eqs[k].I
+        << " R = " << std::setw(10) << eqs[k].R << "  "
+        << stability_name(eqs[k].stability)
+        << (eqs[k].oscillating() ? ", oscillating" : "") << ", eigenvalues";
+    for (int j=0; j<eqs[k].neig; j++) {
+      out << " " << eqs[k].re[j];
+      if (eqs[k].im[j] != 0.0) {
+        out << std::showpos << eqs[k].im[j] << std::noshowpos << "i";
+      }
+    }
+    out << std::endl;
+  }
+}
+
+#endif
@@ -0,0 +1,117 @@
+    /*
+     * The definition module
+     *                      sweep.h
+     * for parameter sweeps: a grid of named parameters given as single
+     * values or ranges on the command line, and a writer that lets many
+     * threads stream their results into one consolidated output file.
+     */
+
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class ParameterGrid
+{
+public:
+  std::vector<std::string> names;
+  std::vector<std::vector<double> > values;
+
+  // Giving a parameter a single value, replacing any earlier values
+  void set(std::string name, double value) {
+    values[index(name)] = std::vector<double>(1, value);
+  }
+
+  /*
+  Reading a parameter from "name=value" or "name=lo:hi:n", the latter
+  giving n evenly spaced values from lo to hi. Only parameters given a
+  default value with set() are known; returns false for other names or
+  if the specification cannot be read.
+  */
+  bool parse(std::string spec) {
+    size_t eq = spec.find('=');
+    if (eq == std::string::npos || eq == 0) return false;
+    std::string name = spec.substr(0, eq);
+    std::string range = spec.substr(eq + 1);
+    if (!has(name)) return false;
+
+    double lo, hi;
+    int n;
+    char* end;
+    lo = strtod(range.c_str(), &end);
+    if (end == range.c_str()) return false;
+    if (*end == '\0') {
+      set(name, lo);
+      return true;
+    }
+    if (*end != ':') return false;
+    hi = strtod(end + 1, &end);
+    if (*end != ':') return false;
+    n = strtol(end + 1, &end, 10);
+    if (*end != '\0' || n < 1) return false;
+
+    std::vector<double> v(n);
+    for (int k=0; k<n; k++) v[k] = n == 1 ? lo : lo + (hi - lo)*k/(n - 1);
+    values[index(name)] = v;
+    return true;
+  }
+
+  // Whether name has been given a value, i.e. is a known parameter
+  bool has(std::string name) const {
+    for (size_t p=0; p<names.size(); p++) {
+      if (names[p] == name) return true;
+    }
+    return false;
+  }
+
+  // Number of scenarios, i.e. combinations of parameter values
+  long size() const {
+    long n = 1;
+    for (size_t p=0; p<values.size(); p++) n *= values[p].size();
+    return n;
+  }
+
+  // Value of a parameter in a given scenario; the first parameter varies
+  // fastest
+  double get(long scenario, std::string name) const {
+    for (size_t p=0; p<names.size(); p++) {
+      long n = values[p].size();
+      if (names[p] == name) return values[p][scenario % n];
+      scenario /= n;
+    }
+    return 0.0;
+  }
+
+private:
+  int index(std::string name) {
+    for (size_t p=0; p<names.size(); p++) {
+      if (names[p] == name) return p;
+    }
+    names.push_back(name);
+    values.push_back(std::vector<double>(1, 0.0));
+    return names.size() - 1;
+  }
+};
+
+// Thread-safe writer: every call to write() appends one block of lines
+class SweepWriter
+{
+public:
+  SweepWriter(std::string filename) : file_(filename) {
+  }
+
+  void write(const std::string& lines) {
+    std::lock_guard<std::mutex> lock(m_);
+    file_ << lines;
+  }
+
+private:
+  std::ofstream file_;
+  std::mutex m_;
+};
+
+#endif
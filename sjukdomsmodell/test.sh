@@ -0,0 +1,35 @@
+# Compiling and running the tests; stops at the first failure
+set -e
+
+c++ -std=c++11 -Wall test_rk4.cpp lib.cpp -o test_rk4.x
+./test_rk4.x
+
+c++ -std=c++11 -Wall test_trajectory.cpp -o test_trajectory.x
+./test_trajectory.x
+
+c++ -std=c++11 -Wall test_trajectory_store.cpp -o test_trajectory_store.x
+./test_trajectory_store.x
+
+c++ -std=c++11 -Wall test_lu.cpp lib.cpp -o test_lu.x
+./test_lu.x
+
+c++ -std=c++11 -Wall test_matrix.cpp lib.cpp -o test_matrix.x
+./test_matrix.x
+
+c++ -std=c++11 -Wall -pthread test_eigen.cpp lib.cpp -o test_eigen.x
+./test_eigen.x
+
+c++ -std=c++11 -Wall test_philox.cpp -o test_philox.x
+./test_philox.x
+
+c++ -std=c++11 -Wall -pthread test_quadrature.cpp lib.cpp -o test_quadrature.x
+./test_quadrature.x
+
+c++ -std=c++11 -Wall test_interpolation.cpp lib.cpp -o test_interpolation.x
+./test_interpolation.x
+
+c++ -std=c++11 -Wall test_roots.cpp lib.cpp -o test_roots.x
+./test_roots.x
+
+c++ -std=c++11 -Wall test_steady_state.cpp lib.cpp -o test_steady_state.x
+./test_steady_state.x
@@ -0,0 +1,206 @@
+// Test of the contiguous tred2()/tqli() in lib.cpp: eigenpairs of
+// symmetric matrices on both sides of the block size, against the
+// double** versions and jacobi(), the eigenvalues-only mode, and the
+// status of tqli() when an eigenvalue does not converge. Then the
+// parallel jacobi() on contiguous storage against the serial one, and
+// its status when it runs out of sweeps. Exits non-zero on failure.
+//   c++ -std=c++11 -Wall -pthread test_eigen.cpp lib.cpp -o test_eigen.x
+
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "lib.h"
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool ok, const char* what)
+{
+  cout << (ok ? "ok      " : "FAILED  ") << what << endl;
+  if (!ok) failures++;
+}
+
+// A symmetric n x n matrix stored row by row, with distinct eigenvalues
+static vector<double> symmetric(int n)
+{
+  vector<double> a((size_t) n*n);
+  for (int i=0; i<n; i++) {
+    for (int j=0; j<=i; j++) {
+      a[(size_t) i*n + j] = a[(size_t) j*n + i] = cos(0.7*(i + 1)*(j + 2) + i + j)
+        + (i == j ? 0.05*i : 0.0);
+    }
+  }
+  return a;
+}
+
+// Largest |A Q - Q Lambda| and |Q^T Q - I| for eigenvectors in the
+// columns of q, relative to the largest eigenvalue
+static void residuals(const vector<double>& a, const double* q, const double* d,
+                      int n, double& residual, double& orthogonality)
+{
+  double scale = 0.0;
+  for (int k=0; k<n; k++) scale = max(scale, fabs(d[k]));
+  residual = orthogonality = 0.0;
+  for (int i=0; i<n; i++) {
+    for (int k=0; k<n; k++) {
+      double aq = 0.0, qq = 0.0;
+      for (int j=0; j<n; j++) {
+        aq += a[(size_t) i*n + j]*q[(size_t) j*n + k];
+        qq += q[(size_t) j*n + i]*q[(size_t) j*n + k];
+      }
+      residual = max(residual, fabs(aq - q[(size_t) i*n + k]*d[k])/scale);
+      orthogonality = max(orthogonality, fabs(qq - (i == k ? 1.0 : 0.0)));
+    }
+  }
+}
+
+// Largest difference between the eigenvalues in d1 and d2 in increasing
+// order, relative to the largest one
+static double eigenvalue_difference(vector<double> d1, vector<double> d2)
+{
+  sort(d1.begin(), d1.end());
+  sort(d2.begin(), d2.end());
+  double scale = max(fabs(d1.front()), fabs(d1.back())), diff = 0.0;
+  for (size_t k=0; k<d1.size(); k++) diff = max(diff, fabs(d1[k] - d2[k]));
+  return diff/scale;
+}
+
+// The eigenvalues from the double** tred2()/tqli(), or from jacobi()
+static vector<double> eigenvalues_nr(const vector<double>& a, int n, bool use_jacobi)
+{
+  double **b = (double **) matrix(n, n, sizeof(double));
+  double **v = (double **) matrix(n, n, sizeof(double));
+  vector<double> d(n), e(n);
+  for (int i=0; i<n; i++) {
+    for (int j=0; j<n; j++) b[i][j] = a[(size_t) i*n + j];
+  }
+  int nrot;
+  if (use_jacobi) jacobi(b, &d[0], v, n, nrot);
+  else {
+    tred2(b, n, &d[0], &e[0]);
+    tqli(&d[0], &e[0], n, b);
+  }
+  free_matrix((void **) b);
+  free_matrix((void **) v);
+  return d;
+}
+
+void test_tred2_tqli()
+{
+  const int sizes[] = {1, 2, 5, 63, 64, 65, 150};
+  bool status = true, orthogonal = true, solved = true;
+  bool same_nr = true, same_jacobi = true, values_only = true;
+  for (int n : sizes) {
+    vector<double> a = symmetric(n), q(a), d(n), e(n);
+    tred2(&q[0], n, &d[0], &e[0]);
+    status = status && tqli(&d[0], &e[0], n, &q[0]) == 0;
+    double residual, orthogonality;
+    residuals(a, &q[0], &d[0], n, residual, orthogonality);
+    solved = solved && residual < 1e-12;
+    orthogonal = orthogonal && orthogonality < 1e-12;
+    same_nr = same_nr && eigenvalue_difference(d, eigenvalues_nr(a, n, false)) < 1e-12;
+    same_jacobi = same_jacobi && eigenvalue_difference(d, eigenvalues_nr(a, n, true)) < 1e-12;
+
+    // Without eigenvectors: a[] is only work space and z = 0
+    vector<double> w(a), d0(n), e0(n);
+    tred2(&w[0], n, &d0[0], &e0[0], 0);
+    status = status && tqli(&d0[0], &e0[0], n, (double *) 0) == 0;
+    values_only = values_only && eigenvalue_difference(d, d0) < 1e-13;
+  }
+  check(status, "tqli() converges for n = 1, 2, 5, 63, 64, 65, 150");
+  check(solved, "A Q = Q Lambda to 1e-12");
+  check(orthogonal, "Q^T Q = I to 1e-12");
+  check(same_nr, "eigenvalues equal those of the double** tred2()/tqli()");
+  check(same_jacobi, "eigenvalues equal those of jacobi()");
+  check(values_only, "eigenvalues only, with vectors = 0 and z = 0");
+}
+
+void test_tqli_failure()
+{
+  // A NaN on the diagonal never splits off, so the second block runs out
+  // of iterations. The first block is diagonal and left alone, so with z
+  // back in column order its first column is still e_0.
+  int n = 3;
+  double d[] = {1.0, 2.0, NAN}, e[] = {0.0, 0.0, 0.5};
+  double z[] = {1, 2, 3,
+                0, 4, 5,
+                0, 6, 7};
+  check(tqli(d, e, n, z) == 1 && z[0] == 1 && z[3] == 0 && z[6] == 0,
+        "tqli() returns 1 with z back in column order");
+
+  double d0[] = {1.0, 2.0, NAN}, e0[] = {0.0, 0.0, 0.5};
+  check(tqli(d0, e0, n, (double *) 0) == 1, "tqli() returns 1 without z");
+}
+
+// Largest difference between the eigenpairs (d1, columns of v1) and
+// (d2, columns of v2), matched by increasing eigenvalue, with the
+// eigenvectors compared up to sign
+static double eigenpair_difference(const double* d1, const double* v1,
+                                   const double* d2, const double* v2, int n)
+{
+  vector<int> k1(n), k2(n);
+  for (int k=0; k<n; k++) k1[k] = k2[k] = k;
+  sort(k1.begin(), k1.end(), [d1](int i, int j) { return d1[i] < d1[j]; });
+  sort(k2.begin(), k2.end(), [d2](int i, int j) { return d2[i] < d2[j]; });
+  double diff = 0.0;
+  for (int k=0; k<n; k++) {
+    double dot = 0.0;
+    for (int i=0; i<n; i++) dot += v1[(size_t) i*n + k1[k]]*v2[(size_t) i*n + k2[k]];
+    diff = max(diff, max(fabs(d1[k1[k]] - d2[k2[k]]), fabs(1.0 - fabs(dot))));
+  }
+  return diff;
+}
+
+void test_jacobi()
+{
+  const int sizes[] = {2, 7, 8, 65, 100};
+  const int threads[] = {1, 4};
+  bool status = true, same = true, solved = true;
+  for (int n : sizes) {
+    vector<double> a = symmetric(n);
+
+    // The serial jacobi() on double**, eigenvectors copied to rows
+    double **b = (double **) matrix(n, n, sizeof(double));
+    double **w = (double **) matrix(n, n, sizeof(double));
+    for (int i=0; i<n; i++) {
+      for (int j=0; j<n; j++) b[i][j] = a[(size_t) i*n + j];
+    }
+    vector<double> d0(n), v0((size_t) n*n);
+    int nrot;
+    status = status && jacobi(b, &d0[0], w, n, nrot) == 0;
+    for (int i=0; i<n; i++) {
+      for (int j=0; j<n; j++) v0[(size_t) i*n + j] = w[i][j];
+    }
+    free_matrix((void **) b);
+    free_matrix((void **) w);
+
+    for (int T : threads) {
+      vector<double> c(a), d(n), v((size_t) n*n);
+      status = status && jacobi(&c[0], &d[0], &v[0], n, nrot, T) == 0;
+      same = same && eigenpair_difference(&d[0], &v[0], &d0[0], &v0[0], n) < 1e-10;
+      double residual, orthogonality;
+      residuals(a, &v[0], &d[0], n, residual, orthogonality);
+      solved = solved && residual < 1e-12 && orthogonality < 1e-12;
+    }
+  }
+  check(status, "jacobi() converges for n odd and even, 1 and 4 threads");
+  check(same, "eigenpairs equal those of the serial jacobi()");
+  check(solved, "A V = V Lambda and V^T V = I to 1e-12");
+
+  // One sweep is not enough, which is reported rather than fatal
+  int n = 65, nrot;
+  vector<double> c1 = symmetric(n), c4(c1), d(n), v((size_t) n*n);
+  check(jacobi(&c1[0], &d[0], &v[0], n, nrot, 1, 1) == 1
+        && jacobi(&c4[0], &d[0], &v[0], n, nrot, 4, 1) == 1,
+        "jacobi() returns 1 when maxsweeps is too small");
+}
+
+int main()
+{
+  test_tred2_tqli();
+  test_tqli_failure();
+  test_jacobi();
+  return failures == 0 ? 0 : 1;
+}
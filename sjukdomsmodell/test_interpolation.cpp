@@ -0,0 +1,143 @@
+// Test of interpolation.h against the routines in lib.cpp and exact
+// results. Exits non-zero on failure.
+//   c++ -std=c++11 -Wall test_interpolation.cpp lib.cpp -o test_interpolation.x
+
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "lib.h"
+#include "interpolation.h"
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool ok, const char* what)
+{
+  cout << (ok ? "ok      " : "FAILED  ") << what << endl;
+  if (!ok) failures++;
+}
+
+// Largest difference between a Spline and splint() at the points xq,
+// one at a time and with evaluate()
+static double spline_difference(const vector<double>& x,
+                                const vector<double>& y,
+                                const vector<double>& xq)
+{
+  size_t n = x.size(), m = xq.size();
+  vector<double> y2(n), ref(m), yq(m);
+  spline((double*) &x[0], (double*) &y[0], n, 1e31, 1e31, &y2[0]);
+  Spline s(&x[0], &y[0], n);
+  double diff = 0.0;
+  for (size_t k=0; k<m; k++) {
+    splint((double*) &x[0], (double*) &y[0], &y2[0], n, xq[k], &ref[k]);
+    diff = max(diff, fabs(s(xq[k]) - ref[k]));
+  }
+  s.evaluate(&xq[0], &yq[0], m);
+  for (size_t k=0; k<m; k++) diff = max(diff, fabs(yq[k] - ref[k]));
+  return diff;
+}
+
+void test_spline()
+{
+  size_t n = 101, m = 5000;
+  vector<double> xu(n), xn(n), yu(n), yn(n);
+  for (size_t i=0; i<n; i++) {
+    double s = (double) i/(n - 1);
+    xu[i] = 10.0*s;
+    xn[i] = 10.0*s*s;
+    yu[i] = sin(xu[i]);
+    yn[i] = sin(xn[i]);
+  }
+
+  // Sorted points, including some outside the knots, and a shuffled copy
+  vector<double> xq(m);
+  for (size_t k=0; k<m; k++) xq[k] = -0.5 + 11.0*k/(m - 1);
+  vector<double> shuffled(xq);
+  for (size_t k=0; k<m; k++) swap(shuffled[k], shuffled[(k*7919) % m]);
+
+  check(Spline(&xu[0], &yu[0], n).uniform() && !Spline(&xn[0], &yn[0], n).uniform(),
+        "Spline detects equally spaced knots");
+  check(spline_difference(xu, yu, xq) < 1e-12,
+        "Spline matches splint(), equal spacing, sorted points");
+  check(spline_difference(xn, yn, xq) < 1e-12,
+        "Spline matches splint(), unequal spacing, sorted points");
+  check(spline_difference(xn, yn, shuffled) < 1e-12,
+        "Spline matches splint(), unequal spacing, unsorted points");
+
+  // Natural ends have zero second derivative
+  Spline natural(&xn[0], &yn[0], n);
+  check(natural.y2()[0] == 0.0 && natural.y2()[n-1] == 0.0,
+        "natural ends have y'' = 0");
+
+  // With the exact end derivatives a cubic is reproduced
+  vector<double> c(n);
+  for (size_t i=0; i<n; i++) c[i] = 1 - 2*xn[i] + 0.5*xn[i]*xn[i]*xn[i];
+  Spline cubic(&xn[0], &c[0], n, -2.0, -2.0 + 1.5*100.0);
+  double err = 0.0;
+  for (size_t k=0; k<m; k++) {
+    double x = 10.0*k/(m - 1);
+    err = max(err, fabs(cubic(x) - (1 - 2*x + 0.5*x*x*x)));
+  }
+  check(err < 1e-9, "clamped spline reproduces a cubic");
+}
+
+void test_barycentric()
+{
+  // Through a polynomial of degree n-1 the interpolant is exact, as is
+  // polint(), and the error estimate vanishes for degree n-2
+  size_t n = 12;
+  vector<double> x(n), y(n), q(n);
+  for (size_t i=0; i<n; i++) {
+    x[i] = (double) i/(n - 1) + 0.01*sin(7.0*i);
+    y[i] = pow(x[i] - 0.3, (double) (n - 1));
+    q[i] = pow(x[i] - 0.3, (double) (n - 2));
+  }
+  Barycentric p(&x[0], &y[0], n), pq(&x[0], &q[0], n);
+  double err = 0.0, dpol = 0.0, est = 0.0;
+  for (int k=0; k<=1000; k++) {
+    double t = k/1000.0, ref, dref, dy;
+    polint(&x[0], &y[0], n, t, &ref, &dref);
+    err = max(err, fabs(p(t) - pow(t - 0.3, (double) (n - 1))));
+    dpol = max(dpol, fabs(ref - pow(t - 0.3, (double) (n - 1))));
+    pq(t, dy);
+    est = max(est, fabs(dy));
+  }
+  check(err < 1e-12, "Barycentric reproduces a polynomial of degree n-1");
+  check(dpol < 1e-12, "polint() reproduces a polynomial of degree n-1");
+  check(est < 1e-12, "error estimate vanishes for degree n-2");
+
+  // At the nodes the values are returned exactly
+  bool exact = true;
+  for (size_t i=0; i<n; i++) {
+    double dy;
+    exact = exact && p(x[i]) == y[i] && p(x[i], dy) == y[i];
+  }
+  check(exact, "Barycentric is exact at the nodes");
+
+  // Chebyshev points: exp to rounding with 20 nodes, and evaluate()
+  // agreeing with operator() point by point, up to contraction into
+  // fused multiply-adds
+  size_t m = 1001;
+  Barycentric c = Barycentric::chebyshev([](double t) { return exp(t); },
+                                         -1.0, 2.0, 20);
+  vector<double> tq(m), yq(m), dq(m);
+  for (size_t k=0; k<m; k++) tq[k] = -1.0 + 3.0*k/(m - 1);
+  c.evaluate(&tq[0], &yq[0], m, &dq[0]);
+  double cerr = 0.0, diff = 0.0;
+  for (size_t k=0; k<m; k++) {
+    double dy;
+    cerr = max(cerr, fabs(yq[k] - exp(tq[k]))/exp(tq[k]));
+    diff = max(diff, fabs(yq[k] - c(tq[k], dy)) + fabs(dq[k] - dy));
+  }
+  check(cerr < 1e-14, "Chebyshev interpolation of exp to 1e-14");
+  check(diff < 1e-13, "evaluate() agrees with operator()");
+}
+
+int main()
+{
+  test_spline();
+  test_barycentric();
+  return failures == 0 ? 0 : 1;
+}
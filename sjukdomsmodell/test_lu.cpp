@@ -0,0 +1,83 @@
+// Test of the blocked ludcmp()/lubksb() on contiguous storage in lib.cpp
+// for n on both sides of the panel width and several right-hand sides:
+// the factors, indx and d against the double** ludcmp(), and the
+// residual of the solutions. Exits non-zero on failure.
+//   c++ -std=c++11 -Wall test_lu.cpp lib.cpp -o test_lu.x
+
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "lib.h"
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool ok, const char* what)
+{
+  cout << (ok ? "ok      " : "FAILED  ") << what << endl;
+  if (!ok) failures++;
+}
+
+// Uniform numbers in (-1, 1) from a linear congruential generator, so that
+// the matrices need row interchanges
+static double next(unsigned long long& state)
+{
+  state = state*6364136223846793005ULL + 1442695040888963407ULL;
+  return (state >> 11)*(2.0/9007199254740992.0) - 1.0;
+}
+
+int main()
+{
+  const int sizes[] = {63, 64, 65, 130, 300};
+  int nrhs = 5;
+  unsigned long long state = 12345;
+  bool same_pivots = true, same_factors = true, solved = true;
+  for (int n : sizes) {
+    vector<double> a((size_t) n*n), b((size_t) n*nrhs);
+    for (size_t k=0; k<a.size(); k++) a[k] = next(state);
+    for (size_t k=0; k<b.size(); k++) b[k] = next(state);
+
+    // The blocked factorization and solve
+    vector<double> lu(a), x(b);
+    vector<int> indx(n);
+    double d;
+    ludcmp(&lu[0], n, &indx[0], &d);
+    lubksb(&lu[0], n, &indx[0], &x[0], nrhs);
+
+    // The row-pointer ludcmp() on the same matrix
+    double **r = (double **) matrix(n, n, sizeof(double));
+    for (int i=0; i<n; i++) {
+      for (int j=0; j<n; j++) r[i][j] = a[(size_t) i*n + j];
+    }
+    vector<int> rindx(n);
+    double rd;
+    ludcmp(r, n, &rindx[0], &rd);
+    double diff = 0.0;
+    for (int i=0; i<n; i++) {
+      for (int j=0; j<n; j++) diff = max(diff, fabs(lu[(size_t) i*n + j] - r[i][j]));
+    }
+    free_matrix((void **) r);
+    same_pivots = same_pivots && indx == rindx && d == rd;
+    same_factors = same_factors && diff < 1e-11;
+
+    // |A X - B| relative to |A| |X|
+    double res = 0.0, anorm = 0.0, xnorm = 0.0;
+    for (size_t k=0; k<a.size(); k++) anorm = max(anorm, fabs(a[k]));
+    for (size_t k=0; k<x.size(); k++) xnorm = max(xnorm, fabs(x[k]));
+    for (int i=0; i<n; i++) {
+      for (int j=0; j<nrhs; j++) {
+        double s = -b[(size_t) i*nrhs + j];
+        for (int k=0; k<n; k++) s += a[(size_t) i*n + k]*x[(size_t) k*nrhs + j];
+        res = max(res, fabs(s));
+      }
+    }
+    solved = solved && res < 1e-14*n*anorm*xnorm;
+  }
+  check(same_pivots, "indx and d equal those of the double** ludcmp()");
+  check(same_factors, "L and U equal those of the double** ludcmp() to 1e-11");
+  check(solved, "A X = B for n = 63, 64, 65, 130, 300 and 5 right-hand sides");
+
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,84 @@
+// Test of matrix.h: aligned padded rows, views and transposes without
+// copies, and RowPointers passing Matrix storage to ludcmp()/lubksb() in
+// lib.cpp, with strided views rejected. Exits non-zero on failure.
+//   c++ -std=c++11 -Wall test_matrix.cpp lib.cpp -o test_matrix.x
+
+#include <iostream>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include "lib.h"
+#include "matrix.h"
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool ok, const char* what)
+{
+  cout << (ok ? "ok      " : "FAILED  ") << what << endl;
+  if (!ok) failures++;
+}
+
+int main()
+{
+  // Padded rows all start on a 64-byte boundary
+  size_t n = 13;
+  Matrix a(n, n, Matrix::padded_stride(n));
+  bool aligned = a.row_stride() >= n;
+  for (size_t i=0; i<n; i++) aligned = aligned && (uintptr_t) a.row(i) % 64 == 0;
+  check(aligned, "padded rows are 64-byte aligned");
+
+  // A diagonally dominant system with known solution x[i] = i + 1
+  for (size_t i=0; i<n; i++) {
+    for (size_t j=0; j<n; j++) a(i, j) = i == j ? 2.0*n : 1.0/(1.0 + i + j);
+  }
+  vector<double> x(n);
+  for (size_t i=0; i<n; i++) {
+    x[i] = 0.0;
+    for (size_t j=0; j<n; j++) x[i] += a(i, j)*(j + 1);
+  }
+
+  // Views see the same elements; a transpose swaps the indices
+  MatrixView v = a.view();
+  MatrixView t = v.transpose();
+  MatrixView b = v.block(2, 3, 4, 5);
+  check(&v(4, 7) == &a(4, 7) && &t(7, 4) == &a(4, 7) && &b(1, 2) == &a(3, 5),
+        "views and transposes refer to the elements of the matrix");
+  check(!v.contiguous() && !t.contiguous() && Matrix(4, 5).view().contiguous(),
+        "contiguous() tells padded and transposed views apart");
+
+  // LU through row pointers, with the elements left in place
+  vector<int> indx(n);
+  double d;
+  RowPointers rows(a);
+  ludcmp(rows, (int) n, &indx[0], &d);
+  lubksb(rows, (int) n, &indx[0], &x[0]);
+  double err = 0.0;
+  for (size_t i=0; i<n; i++) err = max(err, fabs(x[i] - (i + 1)));
+  check(err < 1e-12, "ludcmp()/lubksb() through RowPointers solve A x = b");
+
+  // Rows of a transposed view are not contiguous
+  bool threw = false;
+  try {
+    RowPointers bad(t);
+  } catch (const invalid_argument&) {
+    threw = true;
+  }
+  check(threw, "RowPointers rejects a view with column stride != 1");
+
+  threw = false;
+  try {
+    RowPointers column(t.block(0, 0, n, 1));
+  } catch (const invalid_argument&) {
+    threw = true;
+  }
+  check(!threw, "RowPointers accepts single columns");
+
+  // Moving a matrix hands over its block
+  double* data = a.data();
+  Matrix c(std::move(a));
+  check(c.data() == data && a.data() == 0, "moving a matrix keeps its block");
+
+  return failures == 0 ? 0 : 1;
+}
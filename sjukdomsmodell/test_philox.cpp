@@ -0,0 +1,107 @@
+// Test of philox.h: the known-answer vectors of Random123 for
+// Philox4x32-10, discard() and fill() giving the same numbers as drawing
+// them one at a time, and distinct streams and seeds. Every stochastic
+// result of the Monte Carlo engines depends on these staying the same.
+// Exits non-zero on failure.
+//   c++ -std=c++11 -Wall test_philox.cpp -o test_philox.x
+
+#include <iostream>
+#include <vector>
+#include "philox.h"
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool ok, const char* what)
+{
+  cout << (ok ? "ok      " : "FAILED  ") << what << endl;
+  if (!ok) failures++;
+}
+
+// Block n of stream (seed, stream) equals r[0..3]
+static bool block_is(uint64_t seed, uint64_t stream, uint64_t n,
+                     uint32_t r0, uint32_t r1, uint32_t r2, uint32_t r3)
+{
+  uint32_t r[4];
+  Philox4x32(seed, stream).generate(n, r);
+  return r[0] == r0 && r[1] == r1 && r[2] == r2 && r[3] == r3;
+}
+
+int main()
+{
+  // Counter (n, stream) and key seed, in 32-bit words low to high
+  check(block_is(0, 0, 0, 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8),
+        "known answer for counter 0, key 0");
+  check(block_is(~(uint64_t) 0, ~(uint64_t) 0, ~(uint64_t) 0,
+                 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd),
+        "known answer for counter and key all ones");
+  check(block_is(0x299f31d0a4093822ULL, 0x0370734413198a2eULL,
+                 0x85a308d3243f6a88ULL,
+                 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1),
+        "known answer for the digits of pi");
+
+  // operator() runs through the blocks in order
+  Philox4x32 g(2020, 5);
+  bool in_order = true;
+  for (uint64_t n=0; n<10; n++) {
+    uint32_t r[4];
+    g.generate(n, r);
+    for (int j=0; j<4; j++) in_order = in_order && g() == r[j];
+  }
+  check(in_order, "operator() returns block 0, 1, 2, ... in order");
+
+  // discard(n) skips exactly n numbers from any position
+  bool skipped = true;
+  for (int prefix=0; prefix<5; prefix++) {
+    for (uint64_t n=0; n<13; n++) {
+      Philox4x32 a(7, 3), b(7, 3);
+      for (int k=0; k<prefix; k++) {
+        a();
+        b();
+      }
+      a.discard(n);
+      for (uint64_t k=0; k<n; k++) b();
+      for (int k=0; k<6; k++) skipped = skipped && a() == b();
+    }
+  }
+  Philox4x32 far(7, 3);
+  far.discard(4000000003ULL);
+  uint32_t r[4];
+  far.generate(1000000000, r);
+  check(skipped && far() == r[3], "discard() equals drawing the numbers");
+
+  // fill() equals repeated uniform() after any prefix, and leaves the
+  // generator where uniform() would
+  bool filled = true, in_range = true;
+  for (int prefix=0; prefix<5; prefix++) {
+    for (size_t n=0; n<12; n++) {
+      Philox4x32 a(11, 2), b(11, 2);
+      a.discard(prefix);
+      b.discard(prefix);
+      vector<double> x(n + 1);
+      a.fill(&x[0], n);
+      for (size_t i=0; i<n; i++) {
+        double u = b.uniform();
+        filled = filled && x[i] == u;
+        in_range = in_range && u >= 0.0 && u < 1.0;
+      }
+      filled = filled && a.uniform() == b.uniform() && a() == b();
+    }
+  }
+  check(filled, "fill() equals repeated uniform() after discard()");
+  check(in_range, "uniform() is in [0, 1)");
+
+  // Streams and seeds give different numbers; split() is the stream
+  Philox4x32 s0(2020, 0), s1(2020, 1), t0(2021, 0), split = s0.split(1);
+  bool differ = true, same_split = true;
+  for (int k=0; k<100; k++) {
+    uint32_t a = s0(), b = s1(), c = t0();
+    differ = differ && a != b && a != c;
+    same_split = same_split && split() == b;
+  }
+  check(differ, "distinct streams and seeds differ");
+  check(same_split, "split(stream) equals a generator for that stream");
+
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,182 @@
+// Test of quadrature.h: the cached Gauss-Legendre tables against the
+// gauleg() of Numerical Recipes that computed them on every call and
+// against closed forms, one table shared by all threads, exactness on
+// polynomials of degree 2n-1, batched integrals equal to those of one
+// interval at a time, and the rejection of n < 1. Then romberg():
+// integrals that vanish converge in a few refinements, and nonzero ones
+// still meet the relative tolerance. Exits non-zero on failure.
+//   c++ -std=c++11 -Wall -pthread test_quadrature.cpp lib.cpp -o test_quadrature.x
+
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "quadrature.h"
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool ok, const char* what)
+{
+  cout << (ok ? "ok      " : "FAILED  ") << what << endl;
+  if (!ok) failures++;
+}
+
+// gauleg() as it was before the tables were cached, from Numerical Recipes
+static void gauleg_reference(double x1, double x2, double x[], double w[], int n)
+{
+  int m = (n + 1)/2;
+  double xm = 0.5*(x2 + x1), xl = 0.5*(x2 - x1);
+  for (int i=1; i<=m; i++) {
+    double z = cos(3.14159265359*(i - 0.25)/(n + 0.5)), z1, pp;
+    do {
+      double p1 = 1.0, p2 = 0.0, p3;
+      for (int j=1; j<=n; j++) {
+        p3 = p2;
+        p2 = p1;
+        p1 = ((2.0*j - 1.0)*z*p2 - (j - 1.0)*p3)/j;
+      }
+      pp = n*(z*p1 - p2)/(z*z - 1.0);
+      z1 = z;
+      z = z1 - p1/pp;
+    } while (fabs(z - z1) > ZERO);
+    x[i-1] = xm - xl*z;
+    x[n-i] = xm + xl*z;
+    w[i-1] = w[n-i] = 2.0*xl/((1.0 - z*z)*pp*pp);
+  }
+}
+
+void test_gauss_legendre()
+{
+  // The nodes of gauleg() as before. The old weights used the derivative
+  // at the last but one Newton iterate, good to about 1e-10 and to 1e-6
+  // relative for the smallest weights, so the weights are compared to
+  // that and checked on their own against the weight sum 2 and the
+  // closed forms for 3 points.
+  const int sizes[] = {1, 2, 3, 5, 10, 20, 64, 255, 256, 300};
+  double dx = 0.0, dw = 0.0, dsum = 0.0, dgauleg = 0.0;
+  for (int n : sizes) {
+    vector<double> xr(n), wr(n), x(n), w(n);
+    gauleg_reference(-1.0, 1.0, &xr[0], &wr[0], n);
+    const double* t = gauleg_table(n);
+    double sum = 0.0;
+    for (int i=0; i<n; i++) {
+      dx = max(dx, fabs(t[i] - xr[i]));
+      dw = max(dw, fabs(t[n + i] - wr[i])/t[n + i]);
+      sum += t[n + i];
+    }
+    dsum = max(dsum, fabs(sum - 2.0));
+    gauleg(0.5, 3.0, &x[0], &w[0], n);
+    for (int i=0; i<n; i++) {
+      dgauleg = max(dgauleg, max(fabs(x[i] - (1.75 + 1.25*t[i])),
+                                 fabs(w[i] - 1.25*t[n + i])));
+    }
+  }
+  const double* t3 = gauleg_table(3);
+  double three = max(fabs(t3[0] + sqrt(0.6)), fabs(t3[2] - sqrt(0.6)));
+  three = max(three, max(fabs(t3[3] - 5.0/9), fabs(t3[4] - 8.0/9)));
+  check(dx < 1e-15, "gauleg_table() has the nodes of the uncached gauleg()");
+  check(dw < 1e-6, "and its weights, to their accuracy");
+  check(dsum < 1e-14 && three < 1e-15 && t3[1] == 0.0,
+        "weights sum to 2, and the 3-point rule is exact");
+  check(dgauleg < 1e-15, "gauleg() maps the table to [0.5, 3]");
+
+  // Threads asking for the same n all get the one table, also for n
+  // beyond the lock-free range
+  const int nthreads = 8, n_small = 37, n_large = 400;
+  vector<const double*> small(nthreads), large(nthreads);
+  vector<thread> threads;
+  for (int t=0; t<nthreads; t++) {
+    threads.push_back(thread([&small, &large, t]() {
+      small[t] = gauleg_table(n_small);
+      large[t] = gauleg_table(n_large);
+    }));
+  }
+  for (thread& t: threads) t.join();
+  bool shared = gauleg_table(n_small) == small[0] && gauleg_table(n_large) == large[0]
+    && GaussLegendre(n_small).x() == small[0] && GaussLegendre(n_small).w() == small[0] + n_small;
+  for (int t=1; t<nthreads; t++) {
+    shared = shared && small[t] == small[0] && large[t] == large[0];
+  }
+  check(shared, "one cached table per n, shared by all threads");
+
+  // Exact for polynomials of degree 2n-1, not 2n
+  bool exact = true, not_exact = true;
+  double a = -0.5, b = 1.5;
+  for (int n=1; n<=12; n++) {
+    GaussLegendre g(n);
+    for (int k=0; k<=2*n; k++) {
+      double I = (pow(b, k + 1) - pow(a, k + 1))/(k + 1);
+      double err = fabs(g.integrate([k](double x) { return pow(x, k); }, a, b) - I);
+      if (k < 2*n) exact = exact && err < 1e-14*max(1.0, fabs(I));
+      else not_exact = not_exact && err > 1e-10;
+    }
+  }
+  check(exact, "n points integrate x^k exactly for k <= 2n-1");
+  check(not_exact, "and not x^2n");
+
+  // Batches of intervals, with a remainder, as one at a time
+  size_t m = 1001;
+  vector<double> lo(m), hi(m), batched(m);
+  for (size_t k=0; k<m; k++) {
+    lo[k] = 0.01*k;
+    hi[k] = lo[k] + 0.5 + 0.001*k;
+  }
+  auto f = [](double x) { return exp(-x)*sin(3*x); };
+  bool same = true;
+  for (int n : {1, 7, 20}) {
+    GaussLegendre g(n);
+    g.integrate(pointwise(f), &lo[0], &hi[0], m, &batched[0], 300);
+    for (size_t k=0; k<m; k++) {
+      double one = g.integrate(f, lo[k], hi[k]);
+      same = same && fabs(batched[k] - one) <= 1e-15*fabs(one);
+    }
+  }
+  check(same, "batched integrate() equals one interval at a time");
+
+  bool threw = false;
+  try {
+    GaussLegendre g(0);
+  } catch (const invalid_argument&) {
+    threw = true;
+  }
+  check(threw, "GaussLegendre rejects n < 1");
+}
+
+void test_romberg()
+{
+  double r;
+  long nfev;
+
+  // Odd integrands on symmetric intervals, where only rounding is left
+  int status = romberg(-1.0, 1.0, [](double x) { return sin(3*x)*exp(x*x); },
+                       r, nfev);
+  check(status == 0 && nfev < 1000 && fabs(r) < 1e-14,
+        "odd integrand on [-1, 1] converges to 0");
+  status = romberg(-M_PI, M_PI, [](double x) { return sin(x); }, r, nfev);
+  check(status == 0 && nfev < 1000 && fabs(r) < 1e-14,
+        "sin on [-pi, pi] converges to 0");
+
+  // An explicit absolute tolerance stops earlier on a tiny integral
+  status = romberg(0.0, 1.0, [](double x) { return 1e-12*x*x; }, r, nfev,
+                   1e-10, 20, 1, 1e-20);
+  check(status == 0 && fabs(r - 1e-12/3) < 1e-20, "abs_tol on a tiny integral");
+
+  // Nonzero integrals are still relative to the result
+  status = romberg(0.0, 1.0, [](double x) { return exp(x); }, r, nfev);
+  check(status == 0 && fabs(r - (exp(1.0) - 1))/(exp(1.0) - 1) < 1e-10,
+        "exp on [0, 1] to 1e-10");
+  status = romberg(-1.0, 1.0, [](double x) { return x*x*x*exp(x); }, r, nfev);
+  check(status == 0 && fabs(r - (16/exp(1.0) - 2*exp(1.0))) < 1e-10,
+        "x^3 exp(x) on [-1, 1] to 1e-10");
+}
+
+int main()
+{
+  test_gauss_legendre();
+  test_romberg();
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,124 @@
+// Regression test for the steppers in rk4.h: no heap memory per step, and
+// y'' = -y integrated by rk4<2> agrees with cos and sin. Exits non-zero
+// on failure.
+//   c++ -std=c++11 -Wall test_rk4.cpp lib.cpp -o test_rk4.x && ./test_rk4.x
+
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+#include "lib.h"
+#include "rk4.h"
+
+using namespace std;
+
+// Every heap allocation in the program goes through these
+static long allocations = 0;
+
+void* operator new(size_t size)
+{
+  allocations++;
+  void* p = malloc(size > 0 ? size : 1);
+  if (p == 0) throw bad_alloc();
+  return p;
+}
+
+void* operator new[](size_t size)
+{
+  return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+  free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+  free(p);
+}
+
+static int failures = 0;
+
+static void check(bool ok, const char* what)
+{
+  cout << (ok ? "ok      " : "FAILED  ") << what << endl;
+  if (!ok) failures++;
+}
+
+// y'' = -y as y0' = y1, y1' = -y0
+struct Oscillator
+{
+  void operator()(double, const double* y, double* dydx) const {
+    dydx[0] = y[1];
+    dydx[1] = -y[0];
+  }
+};
+
+// The SIRS right-hand side of main_rk4.cpp with constant rates
+struct SIRS
+{
+  double N, a, b, c;
+
+  void operator()(double, const double* y, double* dydt) const {
+    double inf = a*y[0]*y[1]/N;
+    dydt[0] = c*y[2] - inf;
+    dydt[1] = inf - b*y[1];
+    dydt[2] = b*y[1] - c*y[2];
+  }
+};
+
+static void oscillator(double, double* y, double* dydx)
+{
+  dydx[0] = y[1];
+  dydx[1] = -y[0];
+}
+
+int main()
+{
+  const int steps = 10000;
+  const double h = 1e-3;
+
+  long before = allocations;
+  double* volatile p = new double;
+  delete p;
+  check(allocations == before + 1, "operator new is counted");
+
+  // rk4_step<3> on the SIRS model, conserving S + I + R
+  SIRS sirs = {400, 4, 1, 0.5};
+  double y[3] = {300, 100, 0};
+  before = allocations;
+  for (int i=0; i<steps; i++) rk4_step<3>(y, i*h, h, sirs);
+  check(allocations == before, "rk4_step<3> allocates nothing");
+  check(fabs(y[0] + y[1] + y[2] - 400) < 1e-9, "rk4_step<3> conserves N");
+
+  // rk4<2> with the derivatives passed in, against the exact solution
+  Oscillator osc;
+  double u[2] = {1, 0}, dudx[2];
+  double err = 0.0;
+  before = allocations;
+  for (int i=0; i<steps; i++) {
+    osc(i*h, u, dudx);
+    rk4<2>(u, dudx, i*h, h, u, osc);
+    double x = (i + 1)*h;
+    err = max(err, fabs(u[0] - cos(x)) + fabs(u[1] + sin(x)));
+  }
+  check(allocations == before, "rk4<2> allocates nothing");
+  check(err < 1e-12, "rk4<2> matches cos and sin to 1e-12");
+
+  // rk4() in lib.cpp with a caller-owned work array takes the same steps
+  double v[2] = {1, 0}, dvdx[2], work[6];
+  double w[2] = {1, 0};
+  double diff = 0.0;
+  before = allocations;
+  for (int i=0; i<steps; i++) {
+    oscillator(i*h, v, dvdx);
+    rk4(v, dvdx, 2, i*h, h, v, oscillator, work);
+    rk4_step<2>(w, i*h, h, osc);
+    diff = max(diff, fabs(v[0] - w[0]) + fabs(v[1] - w[1]));
+  }
+  check(allocations == before, "lib.cpp rk4() with work array allocates nothing");
+  check(diff < 1e-14, "lib.cpp rk4() and rk4_step<2> agree to 1e-14");
+
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,149 @@
+// Test of the batched root finders in roots.h against the scalar ones in
+// lib.cpp and exact roots, and of their status codes. Exits non-zero on
+// failure.
+//   c++ -std=c++11 -Wall test_roots.cpp lib.cpp -o test_roots.x
+
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "lib.h"
+#include "roots.h"
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool ok, const char* what)
+{
+  cout << (ok ? "ok      " : "FAILED  ") << what << endl;
+  if (!ok) failures++;
+}
+
+// Final size z of an epidemic with reproduction number R0, the root of
+// z - 1 + exp(-R0 z) in (0, 1), for the scalar root finders
+static double final_size_R0;
+
+static double final_size(double z)
+{
+  return z - 1.0 + exp(-final_size_R0*z);
+}
+
+// x^3 - c, with its derivative for rtnewt()
+static double cube_c;
+
+static double cube(double x)
+{
+  return x*x*x - cube_c;
+}
+
+static void cube_d(double x, double* f, double* df)
+{
+  *f = x*x*x - cube_c;
+  *df = 3*x*x;
+}
+
+// The cube equations for the batched versions, one c per lane
+struct Cube
+{
+  const double* c;
+
+  void operator()(const double* x, double* y, size_t first, size_t n) const {
+    for (size_t i=0; i<n; i++) y[i] = x[i]*x[i]*x[i] - c[first + i];
+  }
+
+  void operator()(const double* x, double* y, double* dy, size_t first,
+                  size_t n) const {
+    for (size_t i=0; i<n; i++) {
+      y[i] = x[i]*x[i]*x[i] - c[first + i];
+      dy[i] = 3*x[i]*x[i];
+    }
+  }
+};
+
+int main()
+{
+  // More lanes than one block, and not a multiple of it
+  size_t m = 1000;
+  double xacc = 1e-10;
+  vector<double> R0(m), x1(m), x2(m), root(m), ref(m);
+  vector<int> status(m), iter(m);
+  for (size_t k=0; k<m; k++) {
+    R0[k] = 1.2 + 3.8*k/m;
+    x1[k] = (R0[k] - 1.0)/(R0[k]*R0[k]);
+    x2[k] = 1.0;
+  }
+  auto f = lanewise([&R0](size_t i, double z) {
+    return z - 1.0 + exp(-R0[i]*z);
+  });
+
+  // Bisection takes the same steps as rtbis()
+  size_t failed = rtbis_batch(f, &x1[0], &x2[0], m, xacc, &root[0], &status[0],
+                              &iter[0]);
+  double diff = 0.0;
+  for (size_t k=0; k<m; k++) {
+    final_size_R0 = R0[k];
+    diff = max(diff, fabs(root[k] - rtbis(final_size, x1[k], x2[k], xacc)));
+  }
+  check(failed == 0 && diff == 0.0, "rtbis_batch() equals rtbis()");
+
+  // Brent against zbrent(), which stops at a relative accuracy of 3e-8,
+  // and against bisection to 1e-14
+  failed = zbrent_batch(f, &x1[0], &x2[0], m, xacc, &root[0], &status[0],
+                        &iter[0]);
+  rtbis_batch(f, &x1[0], &x2[0], m, 1e-14, &ref[0], &status[0]);
+  double dref = 0.0, exact = 0.0;
+  int most = 0;
+  for (size_t k=0; k<m; k++) {
+    final_size_R0 = R0[k];
+    dref = max(dref, fabs(root[k] - zbrent(final_size, x1[k], x2[k], xacc)));
+    exact = max(exact, fabs(root[k] - ref[k]));
+    most = max(most, iter[k]);
+  }
+  check(failed == 0 && dref < 1e-7, "zbrent_batch() matches zbrent() to 1e-7");
+  check(exact < xacc, "zbrent_batch() is within xacc of the root");
+  check(most < 20, "zbrent_batch() takes fewer than 20 iterations");
+
+  // Secant and Newton on x^3 = c against cbrt() and the scalar versions
+  vector<double> c(m), a(m, 0.5), b(m, 3.0);
+  for (size_t k=0; k<m; k++) c[k] = 1.0 + 7.0*k/m;
+  Cube g = {&c[0]};
+  size_t failed_sec = rtsec_batch(g, &a[0], &b[0], m, xacc, &root[0],
+                                  &status[0]);
+  double dsec = 0.0, esec = 0.0;
+  for (size_t k=0; k<m; k++) {
+    cube_c = c[k];
+    dsec = max(dsec, fabs(root[k] - rtsec(cube, a[k], b[k], xacc)));
+    esec = max(esec, fabs(root[k] - cbrt(c[k])));
+  }
+  size_t failed_newt = rtnewt_batch(g, &a[0], &b[0], m, xacc, &root[0],
+                                    &status[0]);
+  double dnewt = 0.0, enewt = 0.0;
+  for (size_t k=0; k<m; k++) {
+    cube_c = c[k];
+    dnewt = max(dnewt, fabs(root[k] - rtnewt(cube_d, a[k], b[k], xacc)));
+    enewt = max(enewt, fabs(root[k] - cbrt(c[k])));
+  }
+  check(failed_sec == 0 && dsec < 1e-12 && esec < xacc,
+        "rtsec_batch() matches rtsec() and cbrt()");
+  check(failed_newt == 0 && dnewt < 1e-12 && enewt < xacc,
+        "rtnewt_batch() matches rtnewt() and cbrt()");
+
+  // Failing lanes get their status without disturbing the others
+  x1[3] = 0.9;                        // f > 0 at both ends
+  failed = zbrent_batch(f, &x1[0], &x2[0], m, xacc, &root[0], &status[0]);
+  check(failed == 1 && status[3] == ROOT_NOT_BRACKETED && status[4] == ROOT_OK,
+        "an unbracketed lane is reported");
+  failed = rtbis_batch(f, &x1[0], &x2[0], m, xacc, &root[0], &status[0], 0, 5);
+  check(failed == m && status[0] == ROOT_MAX_ITERATIONS
+        && status[3] == ROOT_NOT_BRACKETED, "too few iterations are reported");
+  a[7] = 0.9;                         // the root 2 lies outside [a, b]
+  b[7] = 1.0;
+  c[7] = 8.0;
+  failed = rtnewt_batch(g, &a[0], &b[0], m, xacc, &root[0], &status[0]);
+  check(failed == 1 && status[7] == ROOT_OUT_OF_BRACKET
+        && status[6] == ROOT_OK && status[8] == ROOT_OK,
+        "Newton leaving its interval is reported");
+
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,103 @@
+// Test of steady_state.h: the equilibria from long_run() against their
+// closed forms and against integrating the rates with RK4 until the
+// population has settled, and the stability of both equilibria. Exits
+// non-zero on failure.
+//   c++ -std=c++11 -Wall test_steady_state.cpp lib.cpp -o test_steady_state.x
+
+#include <iostream>
+#include <cmath>
+#include "lib.h"
+#include "rk4.h"
+#include "steady_state.h"
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool ok, const char* what)
+{
+  cout << (ok ? "ok      " : "FAILED  ") << what << endl;
+  if (!ok) failures++;
+}
+
+// The SIRS rates of steady_state.h for the steppers in rk4.h
+struct Rates
+{
+  SIRSParameters p;
+
+  void operator()(double, const double* y, double* dydt) const {
+    sirs_rates(p, y, dydt);
+  }
+};
+
+// Largest difference between an equilibrium and (S, I, R) relative to N
+static double distance(const SIRSParameters& p, const Equilibrium& eq,
+                       const double* y)
+{
+  return max(fabs(eq.S - y[0]), max(fabs(eq.I - y[1]), fabs(eq.R - y[2])))/p.N;
+}
+
+// Where the population starting from (300, 100, 0) is at time t
+static void integrate(const SIRSParameters& p, double t, double* y)
+{
+  Rates rates = {p};
+  double h = 0.01;
+  y[0] = 300; y[1] = 100; y[2] = 0;
+  for (long k=0; k*h<t; k++) rk4_step<3>(y, k*h, h, rates);
+}
+
+int main()
+{
+  // Constant population as in main_mc.cpp: S = N b/a, and I from the
+  // balance of recovery and loss of immunity
+  bool closed = true, settled = true, residual = true, stability = true;
+  for (double b=1; b<=3; b++) {
+    SIRSParameters p = {400, 4, b, 0.5, 0, 0, 0, 0};
+    double S = p.N*b/p.a, I = p.c*(p.N - S)/(b + p.c), R = p.N - S - I;
+    Equilibrium eq = long_run(p);
+    double y[3] = {S, I, R}, dydt[3];
+    closed = closed && eq.status == STEADY_OK && distance(p, eq, y) < 1e-12;
+    integrate(p, 300, y);
+    settled = settled && distance(p, eq, y) < 1e-8;
+    double z[3] = {eq.S, eq.I, eq.R};
+    sirs_rates(p, z, dydt);
+    residual = residual && fabs(dydt[0]) + fabs(dydt[1]) + fabs(dydt[2]) < 1e-10*p.N;
+    stability = stability && eq.stability == STABLE
+      && disease_free(p).stability == UNSTABLE;
+  }
+  check(closed, "conserved: long_run() is the closed-form endemic equilibrium");
+  check(settled, "conserved: RK4 settles at the endemic equilibrium");
+  check(residual, "conserved: the rates vanish at the equilibrium");
+  check(stability, "conserved: endemic stable, disease-free unstable");
+
+  // Births and deaths as population A of main_rk4.cpp
+  SIRSParameters p = {400, 4, 1, 0.5, 0.6, 1.0, 1.0, 0};
+  double S = p.N*(p.b + p.d + p.dI)/p.a;
+  double I = (p.e*p.N - p.d*S)/(2*p.d + p.dI);
+  double y[3] = {S, I, (p.b - p.d)*I/p.c};
+  Equilibrium eq = long_run(p);
+  check(eq.status == STEADY_OK && distance(p, eq, y) < 1e-12,
+        "births and deaths: long_run() is the closed form");
+  integrate(p, 300, y);
+  check(distance(p, eq, y) < 1e-8, "births and deaths: RK4 settles there");
+
+  // Vaccination pushing R_0 below 1: the disease dies out, with S and R
+  // split in proportion c : f
+  SIRSParameters v = {400, 4, 1, 0.5, 0, 0, 0, 2.0};
+  eq = long_run(v);
+  double dfe[3] = {v.N*v.c/(v.c + v.f), 0, v.N*v.f/(v.c + v.f)};
+  check(endemic(v).status == STEADY_NONE && eq.status == STEADY_OK
+        && distance(v, eq, dfe) < 1e-12 && eq.stability == STABLE,
+        "vaccination: stable disease-free equilibrium");
+  integrate(v, 300, y);
+  check(distance(v, eq, y) < 1e-8, "vaccination: RK4 settles there");
+
+  // R_0 = 1 exactly: no endemic equilibrium and a marginal disease-free one
+  SIRSParameters m = {400, 4, 4, 0.5, 0, 0, 0, 0};
+  eq = disease_free(m);
+  check(eq.status == STEADY_OK && eq.stability == MARGINAL
+        && endemic(m).status == STEADY_NONE,
+        "R_0 = 1: marginal disease-free equilibrium, no endemic one");
+
+  return failures == 0 ? 0 : 1;
+}
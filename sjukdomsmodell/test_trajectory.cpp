@@ -0,0 +1,236 @@
+// Test of trajectory.h: TrajectoryWriter files read back through the
+// memory-mapped TrajectoryReader in every encoding, the size and error of
+// delta columns, and rejection of files with a bad header or corrupt
+// delta columns. Exits non-zero on failure.
+//   c++ -std=c++11 -Wall test_trajectory.cpp -o test_trajectory.x
+
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "trajectory.h"
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool ok, const char* what)
+{
+  cout << (ok ? "ok      " : "FAILED  ") << what << endl;
+  if (!ok) failures++;
+}
+
+static const char* filename = "test_trajectory.traj";
+
+static const int nsteps = 1500;
+
+// An integer random walk as from one Monte Carlo sample, a smooth curve
+// as from RK4, and a column with a NaN
+struct Columns
+{
+  vector<double> counts, smooth, nan;
+
+  Columns() : counts(nsteps), smooth(nsteps), nan(nsteps) {
+    unsigned long long state = 1;
+    double n = 300;
+    for (int i=0; i<nsteps; i++) {
+      state = state*6364136223846793005ULL + 1442695040888963407ULL;
+      n += (int) (state >> 61) - 3;
+      counts[i] = n;
+      smooth[i] = 400.0/(1.0 + 3.0*exp(-0.01*i)) + 0.5*sin(0.1*i);
+      nan[i] = i == 7 ? NAN : 0.25*i;
+    }
+  }
+};
+
+static bool write(const Columns& x, TrajectoryEncoding encoding, double quantum = 0)
+{
+  TrajectoryWriter writer(filename, encoding, 4096);
+  writer.set_time(2.0, 0.1);
+  writer.set_quantum(quantum);
+  writer.add_parameter("a", 4.0);
+  writer.add_parameter("b", 0.5);
+  writer.add_column("S", x.counts.data(), nsteps);
+  writer.add_column("I", x.smooth.data(), nsteps);
+  writer.add_column("N", x.nan.data(), nsteps);
+  return writer.write();
+}
+
+static long file_size()
+{
+  FILE* fp = fopen(filename, "rb");
+  if (!fp) return -1;
+  fseek(fp, 0, SEEK_END);
+  long size = ftell(fp);
+  fclose(fp);
+  return size;
+}
+
+// Overwriting n bytes at offset of the file
+static void patch(long offset, const void* p, size_t n)
+{
+  FILE* fp = fopen(filename, "r+b");
+  fseek(fp, offset, SEEK_SET);
+  fwrite(p, 1, n, fp);
+  fclose(fp);
+}
+
+// Largest difference between column c and x; NaN must match NaN
+static double difference(const TrajectoryReader& traj, int c,
+                         const vector<double>& x, bool& decoded)
+{
+  vector<double> y(nsteps);
+  decoded = traj.column(c, y.data());
+  double diff = 0.0;
+  for (int i=0; i<nsteps; i++) {
+    if (std::isnan(x[i]) || std::isnan(y[i])) {
+      if (!(std::isnan(x[i]) && std::isnan(y[i]))) diff = INFINITY;
+    } else {
+      diff = max(diff, fabs(y[i] - x[i]));
+    }
+  }
+  return diff;
+}
+
+void test_round_trip()
+{
+  Columns x;
+  bool decoded;
+
+  // Float64 is exact and can be used in place
+  check(write(x, FLOAT64), "writing f64");
+  {
+    TrajectoryReader traj(filename);
+    bool meta = traj.ok() && traj.steps() == nsteps && traj.t0() == 2.0
+      && traj.dt() == 0.1 && traj.nparams() == 2 && traj.ncols() == 3
+      && traj.parameter_name(1) == "b" && traj.parameter(1) == 0.5
+      && traj.column_name(2) == "N";
+    check(meta, "f64: header, parameters and column names");
+    const double* in_place = traj.column_data(1);
+    check(in_place && equal(x.smooth.begin(), x.smooth.end(), in_place)
+          && difference(traj, 0, x.counts, decoded) == 0.0 && decoded
+          && difference(traj, 2, x.nan, decoded) == 0.0 && decoded,
+          "f64: exact, also in place");
+  }
+  long f64_size = file_size();
+
+  // Float32 rounds each value
+  check(write(x, FLOAT32), "writing f32");
+  {
+    TrajectoryReader traj(filename);
+    vector<double> rounded(nsteps);
+    for (int i=0; i<nsteps; i++) rounded[i] = (float) x.smooth[i];
+    check(traj.ok() && traj.column_data(1) == 0
+          && difference(traj, 1, rounded, decoded) == 0.0 && decoded,
+          "f32: values rounded to float");
+  }
+  long f32_size = file_size();
+
+  // Delta: counts exact, smooth to half the default quantum, NaN raw
+  check(write(x, DELTA), "writing delta");
+  {
+    TrajectoryReader traj(filename);
+    double q = trajectory_quantum(x.smooth.data(), nsteps);
+    check(traj.ok() && traj.column_data(0) == 0 && traj.column_name(1) == "I"
+          && difference(traj, 0, x.counts, decoded) == 0.0 && decoded,
+          "delta: integer counts are exact");
+    check(difference(traj, 1, x.smooth, decoded) <= 0.5*q && decoded
+          && q <= 400.0/(1 << 23),
+          "delta: smooth column to half a float32 ulp of its largest value");
+    check(difference(traj, 2, x.nan, decoded) == 0.0 && decoded,
+          "delta: a column with NaN is stored as float64");
+  }
+  long delta_size = file_size();
+
+  // A step takes 4 bytes in f32
+  vector<char> counts, smooth;
+  trajectory_delta_encode(x.counts.data(), nsteps, 0, counts);
+  trajectory_delta_encode(x.smooth.data(), nsteps, 0, smooth);
+  check(counts.size() <= 8 + 2 + (nsteps - 1) && smooth.size() < 3*nsteps,
+        "delta: 1 byte a step for counts and under 3 for the smooth column");
+  check(f32_size < f64_size && delta_size < f64_size,
+        "f32 and delta files smaller than f64");
+
+  // An explicit quantum bounds the error
+  check(write(x, DELTA, 1e-3), "writing delta with quantum 1e-3");
+  {
+    TrajectoryReader traj(filename);
+    check(traj.ok() && difference(traj, 1, x.smooth, decoded) <= 5e-4 + 1e-12
+          && decoded, "delta: error at most half the quantum");
+  }
+}
+
+void test_rejection()
+{
+  Columns x;
+  uint64_t huge = ~(uint64_t) 0;
+
+  check(!TrajectoryReader("no_such_file.traj").ok(), "missing file rejected");
+
+  write(x, FLOAT64);
+  patch(0, "SIRSTRX", 8);
+  check(!TrajectoryReader(filename).ok(), "bad magic rejected");
+
+  write(x, FLOAT64);
+  uint32_t version = 3;
+  patch(offsetof(TrajectoryHeader, version), &version, 4);
+  check(!TrajectoryReader(filename).ok(), "unknown version rejected");
+
+  write(x, FLOAT64);
+  uint32_t encoding = 7;
+  patch(offsetof(TrajectoryHeader, encoding), &encoding, 4);
+  check(!TrajectoryReader(filename).ok(), "unknown encoding rejected");
+
+  write(x, DELTA);
+  version = 1;
+  patch(offsetof(TrajectoryHeader, version), &version, 4);
+  check(!TrajectoryReader(filename).ok(), "version 1 delta rejected");
+
+  write(x, FLOAT64);
+  patch(offsetof(TrajectoryHeader, steps), &huge, 8);
+  check(!TrajectoryReader(filename).ok(), "steps beyond the file rejected");
+
+  write(x, FLOAT64);
+  uint32_t ncols = 1000;
+  patch(offsetof(TrajectoryHeader, ncols), &ncols, 4);
+  check(!TrajectoryReader(filename).ok(), "columns beyond the file rejected");
+
+  // Truncated to half, in the middle of the columns
+  write(x, FLOAT64);
+  long size = file_size();
+  if (truncate(filename, size/2) != 0) size = 0;
+  check(size > 0 && !TrajectoryReader(filename).ok(), "truncated file rejected");
+
+  // A delta column longer than the file, after the header and two
+  // parameters and three column names
+  long lengths = sizeof(TrajectoryHeader) + 2*24 + 3*16;
+  write(x, DELTA);
+  patch(lengths + 8, &huge, 8);
+  check(!TrajectoryReader(filename).ok(), "delta column length beyond the file rejected");
+
+  // A delta column whose last integer is cut off by its length
+  write(x, DELTA);
+  uint64_t bytes;
+  {
+    TrajectoryReader traj(filename);
+    memcpy(&bytes, (const char*) &traj.header() + lengths, 8);
+  }
+  bytes--;
+  patch(lengths, &bytes, 8);
+  {
+    TrajectoryReader traj(filename);
+    vector<double> y(nsteps);
+    check(traj.ok() && !traj.column(0, y.data()), "corrupt delta column reported");
+  }
+  remove(filename);
+}
+
+int main()
+{
+  test_round_trip();
+  test_rejection();
+  return failures == 0 ? 0 : 1;
+}
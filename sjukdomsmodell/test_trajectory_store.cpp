@@ -0,0 +1,115 @@
+// Test of TrajectoryStore: a batch that fits is served by the block kept
+// from the batch before, so repeated batches make no new allocations and
+// the memory held stays at the size of the largest batch. Exits non-zero
+// on failure.
+//   c++ -std=c++11 -Wall test_trajectory_store.cpp -o test_trajectory_store.x
+
+#include <iostream>
+#include <cstdlib>
+#include <new>
+#include <utility>
+#include "trajectory_store.h"
+
+using namespace std;
+
+// Every heap allocation in the program goes through these
+static long heap_allocations = 0;
+
+void* operator new(size_t size)
+{
+  heap_allocations++;
+  void* p = malloc(size > 0 ? size : 1);
+  if (p == 0) throw bad_alloc();
+  return p;
+}
+
+void* operator new[](size_t size)
+{
+  return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+  free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+  free(p);
+}
+
+static int failures = 0;
+
+static void check(bool ok, const char* what)
+{
+  cout << (ok ? "ok      " : "FAILED  ") << what << endl;
+  if (!ok) failures++;
+}
+
+// Filling S, I and R of npops populations as Population::initiate() does
+static void fill(TrajectoryStore& store, size_t npops, size_t steps)
+{
+  for (size_t p=0; p<npops; p++) {
+    for (int c=0; c<3; c++) {
+      double* arr = store.take(steps);
+      for (size_t i=0; i<steps; i++) arr[i] = i;
+    }
+  }
+}
+
+int main()
+{
+  const size_t npops = 64, steps = 3650;
+  const size_t batch_bytes = 3*npops*steps*sizeof(double);
+
+  // The same batch again and again: one allocation in all, and none on
+  // the heap at all after the first batch
+  TrajectoryStore store;
+  bool one_block = true, bounded = true;
+  long before = 0;
+  for (int k=0; k<50; k++) {
+    store.reset(npops, steps);
+    fill(store, npops, steps);
+    one_block = one_block && store.allocations() == 1;
+    bounded = bounded && store.bytes() == batch_bytes;
+    if (k == 0) before = heap_allocations;
+  }
+  check(one_block, "50 equal batches make 1 allocation");
+  check(heap_allocations == before, "later batches make no heap allocations");
+  check(bounded, "bytes held stay at one batch");
+  check(store.peak_bytes() == batch_bytes, "peak bytes is one batch");
+
+  // Smaller batches reuse the block
+  store.reset(npops/2, steps);
+  fill(store, npops/2, steps);
+  check(store.allocations() == 1 && store.bytes() == batch_bytes,
+        "smaller batch reuses the block");
+
+  // A batch overflowing its reservation spills into extra blocks, which
+  // the next reset() merges into one that is kept from then on
+  store.reset(npops, steps);
+  fill(store, npops + 8, steps);
+  long spilled = store.allocations();
+  check(spilled > 1, "overflowing batch spills into new blocks");
+  store.reset(npops, steps);
+  long merged = store.allocations();
+  fill(store, npops + 8, steps);
+  bool kept = true;
+  for (int k=0; k<10; k++) {
+    store.reset(npops, steps);
+    fill(store, npops + 8, steps);
+    kept = kept && store.allocations() == merged;
+  }
+  check(merged == spilled + 1, "reset() merges the spilled blocks");
+  check(kept, "merged block is reused without allocating");
+  check(store.bytes() == 3*(npops + 8)*steps*sizeof(double),
+        "bytes held are those of the largest batch");
+
+  // Moving hands over the memory without allocating
+  before = heap_allocations;
+  TrajectoryStore moved(std::move(store));
+  check(heap_allocations == before && store.bytes() == 0,
+        "moving the store leaves the source empty");
+
+  return failures == 0 ? 0 : 1;
+}
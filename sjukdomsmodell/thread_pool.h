@@ -0,0 +1,125 @@
+    /*
+     * The definition module
+     *                      thread_pool.h
+     * for a small work-stealing thread pool. Every worker has its own
+     * task queue; it takes work from the back of its own queue and, when
+     * that is empty, steals from the front of the others. Tasks of very
+     * different cost (e.g. Monte Carlo runs for small and large N) are
+     * then balanced over the workers as they go.
+     */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+public:
+  ThreadPool(int nthreads) : queued_(0), pending_(0), stop_(false), next_(0) {
+    if (nthreads < 1) nthreads = 1;
+    for (int w=0; w<nthreads; w++) queues_.emplace_back(new Queue);
+    for (int w=0; w<nthreads; w++) {
+      workers_.emplace_back([this, w]() { run(w); });
+    }
+  }
+
+  // Destructor finishes all submitted tasks before joining the workers
+  ~ThreadPool() {
+    wait();
+    {
+      std::lock_guard<std::mutex> lock(m_);
+      stop_ = true;
+    }
+    cv_work_.notify_all();
+    for (auto& worker: workers_) worker.join();
+  }
+
+  int size() const {
+    return workers_.size();
+  }
+
+  // Adding a task; queues are filled round-robin
+  void submit(std::function<void()> task) {
+    Queue& q = *queues_[next_++ % queues_.size()];
+    {
+      std::lock_guard<std::mutex> lock(m_);
+      pending_++;
+    }
+    {
+      std::lock_guard<std::mutex> lock(q.m);
+      q.tasks.push_back(std::move(task));
+    }
+    {
+      std::lock_guard<std::mutex> lock(m_);
+      queued_++;
+    }
+    cv_work_.notify_one();
+  }
+
+  // Blocking until every submitted task has finished
+  void wait() {
+    std::unique_lock<std::mutex> lock(m_);
+    cv_done_.wait(lock, [this]() { return pending_ == 0; });
+  }
+
+private:
+  struct Queue
+  {
+    std::mutex m;
+    std::deque<std::function<void()> > tasks;
+  };
+
+  std::vector<std::unique_ptr<Queue> > queues_;
+  std::vector<std::thread> workers_;
+  std::mutex m_;
+  std::condition_variable cv_work_, cv_done_;
+  std::atomic<long> queued_;    // tasks waiting in some queue
+  long pending_;                // tasks submitted but not finished
+  bool stop_;
+  unsigned next_;
+
+  // Taking a task from the own queue, or stealing one from another
+  bool pop(int w, std::function<void()>& task) {
+    int n = queues_.size();
+    for (int k=0; k<n; k++) {
+      Queue& q = *queues_[(w + k) % n];
+      std::lock_guard<std::mutex> lock(q.m);
+      if (q.tasks.empty()) continue;
+      if (k == 0) {
+        task = std::move(q.tasks.back());
+        q.tasks.pop_back();
+      } else {
+        task = std::move(q.tasks.front());
+        q.tasks.pop_front();
+      }
+      queued_--;
+      return true;
+    }
+    return false;
+  }
+
+  void run(int w) {
+    for (;;) {
+      std::function<void()> task;
+      if (pop(w, task)) {
+        task();
+        std::lock_guard<std::mutex> lock(m_);
+        if (--pending_ == 0) cv_done_.notify_all();
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(m_);
+      cv_work_.wait(lock, [this]() { return stop_ || queued_ > 0; });
+      if (stop_ && queued_ == 0) return;
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,50 @@
+// Converting a binary trajectory file (see trajectory.h) to text columns
+// for plotting: ./traj2txt.x file.traj > file.dat
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include "trajectory.h"
+
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+  if (argc<=1) {
+    cout << "Usage: " << argv[0] << " file.traj" << endl;
+    return 1;
+  }
+
+  TrajectoryReader traj(argv[1]);
+  if (!traj.ok()) {
+    cerr << "Could not read trajectory file '" << argv[1] << "'" << endl;
+    return 1;
+  }
+
+  // Parameters as comments, then a header line with the column names
+  for (int p=0; p<traj.nparams(); p++) {
+    cout << "# " << traj.parameter_name(p) << " = " << traj.parameter(p) << endl;
+  }
+  cout << "#" << setw(14) << "t";
+  for (int c=0; c<traj.ncols(); c++) cout << setw(15) << traj.column_name(c);
+  cout << endl;
+
+  uint64_t steps = traj.steps();
+  vector<vector<double> > columns(traj.ncols(), vector<double>(steps));
+  for (int c=0; c<traj.ncols(); c++) {
+    if (!traj.column(c, columns[c].data())) {
+      cerr << "Column '" << traj.column_name(c) << "' of '" << argv[1]
+           << "' is corrupt" << endl;
+      return 1;
+    }
+  }
+
+  for (uint64_t i=0; i<steps; i++) {
+    cout << setw(15) << setprecision(8) << traj.t0() + i*traj.dt();
+    for (int c=0; c<traj.ncols(); c++) cout << setw(15) << columns[c][i];
+    cout << endl;
+  }
+
+  return 0;
+}
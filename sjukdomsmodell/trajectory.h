@@ -0,0 +1,436 @@
+    /*
+     * The definition module
+     *                      trajectory.h
+     * for a compact binary, columnar file format for trajectories, e.g.
+     * S(t), I(t), R(t) and N(t) from the SIRS models. The file holds
+     *
+     *   header      magic "SIRSTRJ", version, encoding, number of columns
+     *               and parameters, number of steps, t0 and dt
+     *   parameters  nparams x (16-byte name, double value)
+     *   columns     ncols x 16-byte name, for delta ncols x 64-bit byte
+     *               length, then the data of each column contiguously,
+     *               every column starting on a 64-byte boundary
+     *
+     * Columns are stored as float64, float32, or delta. A delta column
+     * rounds the values to integer multiples k_i q of a quantum q and
+     * holds q followed by k_0, k_1 - k_0, ... as zigzag variable-length
+     * integers (LEB128), so a step takes one byte for counts, e.g. of
+     * one Monte Carlo sample, changing by less than 64 from one step to
+     * the next, and 2-3 bytes for smooth curves.
+     * Unless set by the writer, q is 1 for a column of integers and
+     * otherwise the power of two giving float32 resolution at the largest
+     * |value|; the error is at most q/2 and does not accumulate. A column
+     * that cannot be quantized, e.g. with NaN, is stored as q = 0 and
+     * float64 values. Float64 columns can be used in place from a
+     * memory-mapped file. All numbers are in the byte order of the
+     * machine that wrote the file.
+     */
+
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct TrajectoryHeader
+{
+  char       magic[8];
+  uint32_t   version;
+  uint32_t   encoding;
+  uint32_t   ncols;
+  uint32_t   nparams;
+  uint64_t   steps;
+  double     t0;
+  double     dt;
+};
+
+enum TrajectoryEncoding { FLOAT64 = 0, FLOAT32 = 1, DELTA = 2 };
+
+    // The encoding named f64, f32 or delta; false for any other name
+
+inline bool trajectory_encoding(const std::string& name,
+                                TrajectoryEncoding& encoding)
+{
+  if (name == "f64") encoding = FLOAT64;
+  else if (name == "f32") encoding = FLOAT32;
+  else if (name == "delta") encoding = DELTA;
+  else return false;
+  return true;
+}
+
+    // Bytes taken by the data of one float64 or float32 column, before
+    // padding; delta columns have their lengths in the file
+
+inline uint64_t trajectory_column_bytes(uint32_t encoding, uint64_t steps)
+{
+  return encoding == FLOAT64 ? 8*steps : 4*steps;
+}
+
+inline uint64_t trajectory_align(uint64_t offset)
+{
+  return (offset + 63) & ~(uint64_t) 63;
+}
+
+    // The default quantum of a delta column x[0..steps-1]
+
+inline double trajectory_quantum(const double* x, uint64_t steps)
+{
+  double big = 0.0;
+  bool integers = true;
+  for (uint64_t i=0; i<steps; i++) {
+    big = fmax(big, fabs(x[i]));
+    integers = integers && x[i] == floor(x[i]);
+  }
+  if (integers && big < 4503599627370496.0) return 1.0;     // 2^52
+  int e;
+  frexp(big, &e);                                           // big < 2^e
+  return ldexp(1.0, e - 24);
+}
+
+    // Encoding x[0..steps-1] as a delta column with quantum q, or with
+    // the default quantum if q = 0, into out
+
+inline void trajectory_delta_encode(const double* x, uint64_t steps, double q,
+                                    std::vector<char>& out)
+{
+  if (!(q > 0.0)) q = trajectory_quantum(x, steps);
+  bool fits = std::isfinite(q);
+  for (uint64_t i=0; i<steps && fits; i++) fits = fabs(x[i]/q) < 4503599627370496.0;
+  if (!fits) q = 0.0;
+
+  out.clear();
+  out.insert(out.end(), (const char*) &q, (const char*) &q + 8);
+  if (q == 0.0) {
+    out.insert(out.end(), (const char*) x, (const char*) (x + steps));
+    return;
+  }
+  int64_t prev = 0;
+  for (uint64_t i=0; i<steps; i++) {
+    int64_t k = llround(x[i]/q);
+    int64_t d = k - prev;
+    uint64_t z = ((uint64_t) d << 1) ^ (uint64_t) (d >> 63);   // zigzag
+    prev = k;
+    while (z >= 0x80) {
+      out.push_back((char) (z | 0x80));
+      z >>= 7;
+    }
+    out.push_back((char) z);
+  }
+}
+
+    // Decoding the delta column p[0..bytes-1] into out[0..steps-1].
+    // Returns false if the column is malformed.
+
+inline bool trajectory_delta_decode(const char* p, uint64_t bytes,
+                                    uint64_t steps, double* out)
+{
+  double q;
+  if (bytes < 8) return false;
+  memcpy(&q, p, 8);
+  if (q == 0.0) {
+    if (bytes != 8 + 8*steps) return false;
+    memcpy(out, p + 8, 8*steps);
+    return true;
+  }
+  if (!(q > 0.0) || !std::isfinite(q)) return false;
+  uint64_t pos = 8, k = 0;
+  for (uint64_t i=0; i<steps; i++) {
+    uint64_t z = 0;
+    unsigned char c;
+    int shift = 0;
+    do {
+      if (pos == bytes || shift > 63) return false;
+      c = p[pos++];
+      z |= (uint64_t) (c & 0x7f) << shift;
+      shift += 7;
+    } while (c & 0x80);
+    k += (z >> 1) ^ (0 - (z & 1));                            // unzigzag
+    out[i] = (int64_t) k*q;
+  }
+  return pos == bytes;
+}
+
+class TrajectoryWriter
+{
+public:
+  TrajectoryWriter(std::string filename, TrajectoryEncoding encoding = FLOAT64,
+                   size_t buffer_size = 1 << 20)
+    : filename_(filename), encoding_(encoding), t0_(0.0), dt_(1.0),
+      quantum_(0.0), steps_(0), capacity_(buffer_size), offset_(0), fp_(0) {
+  }
+
+  void set_time(double t0, double dt) {
+    t0_ = t0;
+    dt_ = dt;
+  }
+
+  // Quantum of all delta columns; 0 chooses one for each column
+  void set_quantum(double quantum) {
+    quantum_ = quantum;
+  }
+
+  void add_parameter(std::string name, double value) {
+    params_.push_back(name);
+    values_.push_back(value);
+  }
+
+  // Adding a column; data[0..steps-1] must stay valid until write()
+  void add_column(std::string name, const double* data, uint64_t steps) {
+    names_.push_back(name);
+    columns_.push_back(data);
+    steps_ = steps;
+  }
+
+  // Writing the whole file through one buffer. Returns false on failure.
+  bool write() {
+    // Delta columns are encoded first, as their lengths come before them
+    std::vector<std::vector<char> > encoded;
+    if (encoding_ == DELTA) {
+      encoded.resize(columns_.size());
+      for (size_t c=0; c<columns_.size(); c++) {
+        trajectory_delta_encode(columns_[c], steps_, quantum_, encoded[c]);
+      }
+    }
+
+    FILE* fp = fopen(filename_.c_str(), "wb");
+    if (!fp) return false;
+    buffer_.clear();
+    buffer_.reserve(capacity_);
+    offset_ = 0;
+    fp_ = fp;
+
+    TrajectoryHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, "SIRSTRJ", 8);
+    h.version = 2;
+    h.encoding = encoding_;
+    h.ncols = columns_.size();
+    h.nparams = params_.size();
+    h.steps = steps_;
+    h.t0 = t0_;
+    h.dt = dt_;
+    put(&h, sizeof(h));
+
+    for (size_t p=0; p<params_.size(); p++) {
+      put_name(params_[p]);
+      put(&values_[p], sizeof(double));
+    }
+    for (size_t c=0; c<names_.size(); c++) put_name(names_[c]);
+    for (size_t c=0; c<encoded.size(); c++) {
+      uint64_t bytes = encoded[c].size();
+      put(&bytes, 8);
+    }
+
+    for (size_t c=0; c<columns_.size(); c++) {
+      pad();
+      const double* x = columns_[c];
+      if (encoding_ == FLOAT64) {
+        put(x, 8*steps_);
+      } else if (encoding_ == FLOAT32) {
+        for (uint64_t i=0; i<steps_; i++) {
+          float v = x[i];
+          put(&v, 4);
+        }
+      } else {
+        put(encoded[c].data(), encoded[c].size());
+      }
+    }
+    pad();
+    flush();
+    bool ok = !ferror(fp);
+    fclose(fp);
+    return ok;
+  }
+
+private:
+  std::string filename_;
+  TrajectoryEncoding encoding_;
+  double t0_, dt_, quantum_;
+  uint64_t steps_;
+  std::vector<std::string> params_, names_;
+  std::vector<double> values_;
+  std::vector<const double*> columns_;
+  std::vector<char> buffer_;
+  size_t capacity_;
+  uint64_t offset_;
+  FILE* fp_;
+
+  void put(const void* p, size_t n) {
+    const char* c = (const char*) p;
+    while (n > 0) {
+      if (buffer_.size() == capacity_) flush();
+      size_t k = capacity_ - buffer_.size();
+      if (k > n) k = n;
+      buffer_.insert(buffer_.end(), c, c + k);
+      c += k;
+      n -= k;
+    }
+  }
+
+  void put_name(const std::string& name) {
+    char s[16];
+    memset(s, 0, 16);
+    strncpy(s, name.c_str(), 15);
+    put(s, 16);
+  }
+
+  // Zero bytes up to the next 64-byte boundary of the file
+  void pad() {
+    static const char zeros[64] = {0};
+    uint64_t pos = offset_ + buffer_.size();
+    put(zeros, trajectory_align(pos) - pos);
+  }
+
+  void flush() {
+    fwrite(buffer_.data(), 1, buffer_.size(), fp_);
+    offset_ += buffer_.size();
+    buffer_.clear();
+  }
+};
+
+class TrajectoryReader
+{
+public:
+  // Memory-mapping a trajectory file; check ok() afterwards
+  TrajectoryReader(std::string filename) : data_(0), size_(0) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size >= (off_t) sizeof(TrajectoryHeader)) {
+      void* p = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p != MAP_FAILED) {
+        data_ = (const char*) p;
+        size_ = st.st_size;
+      }
+    }
+    close(fd);
+    if (data_ && !valid()) {
+      munmap((void*) data_, size_);
+      data_ = 0;
+    }
+  }
+
+  ~TrajectoryReader() {
+    if (data_) munmap((void*) data_, size_);
+  }
+
+  TrajectoryReader(const TrajectoryReader&) = delete;
+  TrajectoryReader& operator=(const TrajectoryReader&) = delete;
+
+  bool ok() const { return data_ != 0; }
+
+  const TrajectoryHeader& header() const {
+    return *(const TrajectoryHeader*) data_;
+  }
+
+  uint64_t steps() const { return header().steps; }
+  double t0() const { return header().t0; }
+  double dt() const { return header().dt; }
+  int ncols() const { return header().ncols; }
+  int nparams() const { return header().nparams; }
+
+  std::string parameter_name(int p) const {
+    return name_at(sizeof(TrajectoryHeader) + 24*p);
+  }
+
+  double parameter(int p) const {
+    double v;
+    memcpy(&v, data_ + sizeof(TrajectoryHeader) + 24*p + 16, 8);
+    return v;
+  }
+
+  std::string column_name(int c) const {
+    return name_at(names_offset() + 16*c);
+  }
+
+  // Column c in place if it is stored as float64, otherwise null
+  const double* column_data(int c) const {
+    if (header().encoding != FLOAT64) return 0;
+    return (const double*) (data_ + column_offset(c));
+  }
+
+  // Decoding column c into out[0..steps-1]. Returns false if a delta
+  // column is malformed.
+  bool column(int c, double* out) const {
+    const char* p = data_ + column_offset(c);
+    uint64_t n = steps();
+    if (header().encoding == FLOAT64) {
+      memcpy(out, p, 8*n);
+    } else if (header().encoding == FLOAT32) {
+      for (uint64_t i=0; i<n; i++) {
+        float v;
+        memcpy(&v, p + 4*i, 4);
+        out[i] = v;
+      }
+    } else {
+      return trajectory_delta_decode(p, column_bytes(c), n, out);
+    }
+    return true;
+  }
+
+private:
+  const char* data_;
+  size_t size_;
+
+  uint64_t names_offset() const {
+    return sizeof(TrajectoryHeader) + 24*(uint64_t) nparams();
+  }
+
+  // Where the lengths of delta columns are, after the column names
+  uint64_t lengths_offset() const {
+    return names_offset() + 16*(uint64_t) ncols();
+  }
+
+  uint64_t column_bytes(int c) const {
+    if (header().encoding != DELTA) {
+      return trajectory_column_bytes(header().encoding, steps());
+    }
+    uint64_t bytes;
+    memcpy(&bytes, data_ + lengths_offset() + 8*(uint64_t) c, 8);
+    return bytes;
+  }
+
+  uint64_t column_offset(int c) const {
+    if (header().encoding != DELTA) {
+      return trajectory_align(lengths_offset())
+        + c*trajectory_align(column_bytes(0));
+    }
+    uint64_t offset = trajectory_align(lengths_offset() + 8*(uint64_t) ncols());
+    for (int j=0; j<c; j++) offset += trajectory_align(column_bytes(j));
+    return offset;
+  }
+
+  std::string name_at(uint64_t offset) const {
+    return std::string(data_ + offset, strnlen(data_ + offset, 16));
+  }
+
+  // Version 1 files differ only in their delta columns, which are not
+  // read any more. Every length is checked against the size of the file
+  // before it is added, so a corrupt header cannot wrap the offsets.
+  bool valid() const {
+    const TrajectoryHeader& h = header();
+    if (memcmp(h.magic, "SIRSTRJ", 8) != 0 || h.encoding > DELTA) return false;
+    if (h.version != 2 && !(h.version == 1 && h.encoding != DELTA)) return false;
+    if (h.steps > size_ || h.ncols > size_ || h.nparams > size_) return false;
+    uint64_t offset = lengths_offset();
+    if (h.encoding == DELTA) offset += 8*(uint64_t) h.ncols;
+    if (offset > size_) return false;
+    offset = trajectory_align(offset);
+    for (uint32_t c=0; c<h.ncols; c++) {
+      uint64_t bytes = column_bytes(c);
+      if (offset > size_ || bytes > size_ - offset) return false;
+      offset += trajectory_align(bytes);
+    }
+    return offset <= size_;
+  }
+};
+
+#endif
@@ -0,0 +1,131 @@
+    /*
+     * The definition module
+     *                      trajectory_store.h
+     * for an arena holding the S, I and R arrays of a batch of
+     * populations. A batch is one contiguous allocation which is kept and
+     * reused by the next batch, e.g. in the next iteration of a parameter
+     * sweep, so repeated runs do not allocate or fragment memory. The
+     * store is move-only and owns all memory it hands out.
+     */
+
+#ifndef TRAJECTORY_STORE_H
+#define TRAJECTORY_STORE_H
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include <sys/resource.h>
+
+class TrajectoryStore
+{
+public:
+  TrajectoryStore() : used_(0), allocations_(0), peak_(0) {
+  }
+
+  ~TrajectoryStore() {
+    release();
+  }
+
+  TrajectoryStore(const TrajectoryStore&) = delete;
+  TrajectoryStore& operator=(const TrajectoryStore&) = delete;
+
+  TrajectoryStore(TrajectoryStore&& other)
+    : blocks_(std::move(other.blocks_)), sizes_(std::move(other.sizes_)),
+      used_(other.used_),
+      allocations_(other.allocations_), peak_(other.peak_) {
+    other.blocks_.clear();
+    other.sizes_.clear();
+    other.used_ = 0;
+  }
+
+  TrajectoryStore& operator=(TrajectoryStore&& other) {
+    if (this != &other) {
+      release();
+      blocks_ = std::move(other.blocks_);
+      sizes_ = std::move(other.sizes_);
+      used_ = other.used_;
+      allocations_ = other.allocations_;
+      peak_ = other.peak_;
+      other.blocks_.clear();
+      other.sizes_.clear();
+      other.used_ = 0;
+    }
+    return *this;
+  }
+
+  /*
+  Starting a new batch of npops populations with steps values in each of
+  S, I and R. All arrays handed out earlier become invalid. The memory is
+  only reallocated if the batch does not fit in the current block, and a
+  batch that overflowed into extra blocks is merged into one.
+  */
+  void reset(size_t npops, size_t steps) {
+    size_t need = 3*npops*steps;
+    size_t total = 0;
+    for (size_t k=0; k<sizes_.size(); k++) total += sizes_[k];
+    if (need < total && blocks_.size() > 1) need = total;
+    if (blocks_.size() != 1 || sizes_[0] < need) {
+      release();
+      allocate(need);
+    }
+    used_ = 0;
+  }
+
+  // Taking n consecutive doubles from the current batch
+  double* take(size_t n) {
+    if (blocks_.empty() || used_ + n > sizes_.back()) {
+      allocate(n);          // batch is full: spill into a new block
+      used_ = 0;
+    }
+    double* p = blocks_.back() + used_;
+    used_ += n;
+    return p;
+  }
+
+  // Number of allocations made since construction
+  long allocations() const {
+    return allocations_;
+  }
+
+  // Bytes currently held, and the largest number held at any time
+  size_t bytes() const {
+    size_t total = 0;
+    for (size_t k=0; k<sizes_.size(); k++) total += sizes_[k];
+    return total*sizeof(double);
+  }
+
+  size_t peak_bytes() const {
+    return peak_;
+  }
+
+private:
+  std::vector<double*> blocks_;
+  std::vector<size_t> sizes_;
+  size_t used_;           // doubles used in the last block
+  long allocations_;
+  size_t peak_;
+
+  void allocate(size_t n) {
+    if (n == 0) n = 1;
+    blocks_.push_back(new double[n]);
+    sizes_.push_back(n);
+    allocations_++;
+    if (bytes() > peak_) peak_ = bytes();
+  }
+
+  void release() {
+    for (size_t k=0; k<blocks_.size(); k++) delete[] blocks_[k];
+    blocks_.clear();
+    sizes_.clear();
+  }
+};
+
+// Peak resident set size of the process in kilobytes
+inline long peak_rss_kb()
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+#endif